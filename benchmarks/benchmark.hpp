@@ -0,0 +1,37 @@
+#pragma once
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace benchmarks {
+
+/**
+ * @brief Measures a function
+ *
+ * Calls \p f \p iterations times after a short warm-up and returns the mean duration of a single call in microseconds
+ */
+template<typename F>
+double measure(F f, size_t iterations) {
+	for (size_t i = 0; i < iterations / 10 + 1; ++i) {
+		f();
+	}
+	const auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < iterations; ++i) {
+		f();
+	}
+	const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / iterations;
+}
+
+/**
+ * @brief Prints a measurement
+ *
+ * Prints the duration \p us in microseconds, labeled with \p name
+ */
+inline void report(const std::string &name, double us) {
+	std::cout << std::left << std::setw(40) << name << std::right << std::setw(12) << std::fixed << std::setprecision(2) << us << " us" << std::endl;
+}
+
+}
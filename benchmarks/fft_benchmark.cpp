@@ -0,0 +1,33 @@
+#include <array>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "fft/builtin_fft.hpp"
+#include "fft/fft.hpp"
+#include "util/music.hpp"
+
+int main() {
+	// compares the bundled FFT to the FFT backend of the library, which is fftw if available
+	constexpr const std::array sizes = {size_t {256}, size_t {1024}, size_t {4096}, size_t {16384}};
+	constexpr const float sample_rate = 48000.f;
+	for (const auto size : sizes) {
+		const size_t iterations = (1 << 24) / size;
+		std::vector<float> samples(size);
+		fftune::gen_harmonic(fftune::FreqA4, sample_rate, samples.data(), size);
+
+		const fftune::builtin_fft transform {size};
+		std::vector<std::complex<float>> values(size / 2 + 1);
+		benchmarks::report("builtin " + std::to_string(size), benchmarks::measure([&] { transform.forward(samples.data(), values.data()); }, iterations));
+
+#ifdef HAS_FFTW3F
+		const auto plan = fftune::plan_cache::get(fftune::plan_kind::RealToComplex, size, fftune::fft_heuristic_to_flag(fftune::fft_heuristic::OptimizeRuntime));
+		auto *in = fftune::plan_cache::alloc_real(size);
+		auto *out = fftune::plan_cache::alloc_complex(size / 2 + 1);
+		std::copy(samples.begin(), samples.end(), in);
+		benchmarks::report("fftw " + std::to_string(size), benchmarks::measure([&] { fftune::plan_cache::execute(plan, in, out); }, iterations));
+		fftune::plan_cache::free_buffer(in);
+		fftune::plan_cache::free_buffer(out);
+#endif
+	}
+	return 0;
+}
@@ -0,0 +1,48 @@
+#include <vector>
+
+#include "benchmark.hpp"
+#include "pitch/pitch.hpp"
+#include "util/music.hpp"
+#include "util/simd.hpp"
+
+int main() {
+	// compares every kernel of every supported instruction set on a buffer of the default size
+	constexpr const size_t size = 4096;
+	constexpr const size_t iterations = 200000;
+	// the lags evaluated per difference function
+	constexpr const size_t lags = 1024;
+	std::vector<float> a(size), b(size), dest(size);
+	fftune::gen_sine(fftune::FreqA4, 48000.f, a.data(), size);
+	fftune::gen_harmonic(fftune::FreqA4 / 4.f, 48000.f, b.data(), size);
+
+	volatile float sink = 0.f;
+	for (const auto set : {fftune::simd::instruction_set::Scalar, fftune::simd::instruction_set::Sse2, fftune::simd::instruction_set::Avx2, fftune::simd::instruction_set::Avx512}) {
+		if (!fftune::simd::supported(set)) {
+			continue;
+		}
+		const auto &kernels = fftune::simd::get(set);
+		const std::string name = fftune::simd::to_string(set);
+		benchmarks::report(name + " squared_difference", benchmarks::measure([&] { sink = kernels.squared_difference(a.data(), a.data() + 1, size - 1); }, iterations));
+		benchmarks::report(name + " lags single", benchmarks::measure([&] {
+			for (size_t tau = 0; tau < lags; ++tau) {
+				sink = kernels.squared_difference(b.data(), b.data() + tau, size - tau);
+			}
+		}, iterations / lags));
+		benchmarks::report(name + " lags blocked", benchmarks::measure([&] {
+			float sums[fftune::simd::lag_block];
+			for (size_t tau = 0; tau < lags; tau += fftune::simd::lag_block) {
+				kernels.squared_differences(b.data(), size, tau, sums);
+			}
+			sink = sums[0];
+		}, iterations / lags));
+		benchmarks::report(name + " sum_abs", benchmarks::measure([&] { sink = kernels.sum_abs(a.data(), size); }, iterations));
+		benchmarks::report(name + " scale", benchmarks::measure([&] { kernels.scale(dest.data(), 1.f, size); }, iterations));
+		benchmarks::report(name + " multiply", benchmarks::measure([&] { kernels.multiply(a.data(), b.data(), dest.data(), size); }, iterations));
+		benchmarks::report(name + " minmax", benchmarks::measure([&] {
+			float min, max;
+			kernels.minmax(b.data(), size, min, max);
+			sink = max - min;
+		}, iterations));
+	}
+	return 0;
+}
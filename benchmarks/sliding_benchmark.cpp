@@ -0,0 +1,27 @@
+#include <array>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "fft/fft.hpp"
+#include "util/music.hpp"
+
+int main() {
+	// compares the sliding spectrum to transforming every frame from scratch, per frame of a stream with small hops
+	constexpr const std::array hops = {size_t {16}, size_t {32}, size_t {64}, size_t {128}};
+	constexpr const size_t num_frames = 256;
+	fftune::config conf {.window = fftune::window_type::Hanning};
+	for (const auto hop : hops) {
+		conf.hop_size = hop;
+		std::vector<float> stream(conf.buffer_size + (num_frames - 1) * hop);
+		fftune::gen_harmonic(fftune::FreqA4, conf.sample_rate, stream.data(), stream.size());
+		std::vector<fftune::spectrum_buffer> spectra(num_frames);
+
+		conf.spectrum = fftune::spectrum_method::Fft;
+		fftune::fft full {conf};
+		benchmarks::report("fft hop " + std::to_string(hop), benchmarks::measure([&] { full.detect(stream.data(), num_frames, hop, spectra); }, 20) / num_frames);
+		conf.spectrum = fftune::spectrum_method::Sliding;
+		fftune::fft sliding {conf};
+		benchmarks::report("sliding hop " + std::to_string(hop), benchmarks::measure([&] { sliding.detect(stream.data(), num_frames, hop, spectra); }, 20) / num_frames);
+	}
+	return 0;
+}
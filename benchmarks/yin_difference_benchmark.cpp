@@ -0,0 +1,42 @@
+#include <array>
+#include <utility>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "pitch/difference_function.hpp"
+#include "util/music.hpp"
+
+int main() {
+	// compares the ways to compute the Yin difference function, per frame of a stream with overlapping buffers
+	constexpr const std::array methods = {
+		std::pair {fftune::difference_method::Direct, "direct"},
+		std::pair {fftune::difference_method::Fft, "fft"},
+		std::pair {fftune::difference_method::Incremental, "incremental"},
+		std::pair {fftune::difference_method::Decimated, "decimated"},
+	};
+	constexpr const size_t num_frames = 64;
+	fftune::config conf {.buffer_size = 4096, .hop_size = 256};
+	std::vector<float> stream(conf.buffer_size + (num_frames - 1) * conf.hop_size);
+	fftune::gen_harmonic(110.f, conf.sample_rate, stream.data(), stream.size());
+
+	double direct = 0.0;
+	for (const auto &[method, name] : methods) {
+		conf.yin_difference = method;
+		fftune::difference_function difference {conf};
+		volatile float sink = 0.f;
+		const auto us = benchmarks::measure([&] {
+			for (size_t frame = 0; frame < num_frames; ++frame) {
+				difference.update(stream.data() + frame * conf.hop_size);
+				for (size_t tau = 1; tau <= difference.max_lag(); ++tau) {
+					sink = sink + difference(tau);
+				}
+			}
+		}, 10) / num_frames;
+		if (method == fftune::difference_method::Direct) {
+			direct = us;
+		}
+		benchmarks::report(name, us);
+		std::cout << std::left << std::setw(40) << "  relative to direct" << std::right << std::setw(12) << std::setprecision(3) << us / direct << std::endl;
+	}
+	return 0;
+}
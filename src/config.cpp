@@ -37,6 +37,12 @@ config_error config::error() const {
 		result = config_error::Externalpath_Missing;
 	} else if (algorithm == pitch_detection_method::Invalid) {
 		result = config_error::InvalidAlgorithm;
+	} else if (!midi_valid(min_note) || !midi_valid(max_note) || min_note > max_note) {
+		result = config_error::Invalid_Note_Range;
+	} else if (spectrum == spectrum_method::Sliding && window == window_type::Welch) {
+		result = config_error::Sliding_Window;
+	} else if (yin_difference == difference_method::Decimated && (yin_decimation == 0 || yin_decimation > freq_to_wavelength(max_frequency(), sample_rate))) {
+		result = config_error::Invalid_Decimation;
 	}
 
 	return result;
@@ -53,9 +59,27 @@ std::string config::error_str() const {
 		return "This pitch detection method requires the external path to be set.";
 	case config_error::InvalidAlgorithm:
 		return "Invalid algorithm chosen.";
+	case config_error::Invalid_Note_Range:
+		return "Invalid note range. The notes must be playable on a piano and the lowest note must not be higher than the highest note.";
+	case config_error::Sliding_Window:
+		return "The sliding spectrum requires a rectangular, hanning or hamming window.";
+	case config_error::Invalid_Decimation:
+		return "Invalid Yin decimation. The decimation factor must be at least 1 and at most the period of the highest note in samples.";
 	default:
 		return "Config error";
 	}
 }
 
+bool config::note_in_range(int note) const {
+	return note >= min_note && note <= max_note;
+}
+
+float config::min_frequency() const {
+	return midi_to_freq(min_note) / std::sqrt(SemitoneRatio);
+}
+
+float config::max_frequency() const {
+	return midi_to_freq(max_note) * std::sqrt(SemitoneRatio);
+}
+
 }
@@ -2,6 +2,8 @@
 
 #include <util/util.hpp>
 
+#include "pitch/pitch.hpp"
+
 namespace fftune {
 
 /**
@@ -26,6 +28,40 @@ enum class pitch_detection_method {
  */
 pitch_detection_method method_from_string(const std::string &m);
 
+/**
+ * @brief An enum describing how the Yin difference function is computed
+ *
+ * This enum holds all possible ways to compute the difference function of the Yin based algorithms
+ */
+enum class difference_method {
+	Direct,
+	Fft,
+	Incremental,
+	Decimated,
+};
+
+/**
+ * @brief An enum describing how a frequency spectrum is computed
+ *
+ * This enum holds all possible ways to compute the spectrum of the FFT based algorithms
+ */
+enum class spectrum_method {
+	Fft,
+	Sliding,
+};
+
+/**
+ * @brief An enum describing a windowing function
+ *
+ * This enum holds all windowing functions that can be applied before a FFT
+ */
+enum class window_type {
+	Rectangular,
+	Hanning,
+	Hamming,
+	Welch,
+};
+
 /**
  * @brief An enum representing a config error
  *
@@ -36,6 +72,9 @@ enum class config_error {
 	Hop_Mismatch,
 	Externalpath_Missing,
 	InvalidAlgorithm,
+	Invalid_Note_Range,
+	Sliding_Window,
+	Invalid_Decimation,
 };
 /**
  * @brief Returns whether a config_error is okay
@@ -108,6 +147,83 @@ public:
 	 * Some pitch detection algorithms make use of an external path. In that case this path must be set to a valid value and must not go out of scope until the pitch detection method returns.
 	 */
 	const std::filesystem::path *external_path = nullptr;
+	/**
+	 * @brief The method used to compute the Yin difference function
+	 *
+	 * difference_method::Direct computes every lag on demand in \f$O(n^2)\f$,
+	 * difference_method::Fft computes all lags at once via an autocorrelation in \f$O(n \log n)\f$.
+	 * difference_method::Incremental keeps the lags of the previous buffer and only accounts for the \a hop_size samples
+	 * that were shifted in and out, which costs \f$O(n \cdot hop)\f$ per buffer if consecutive buffers overlap.
+	 * It still touches every lag of the note range for every buffer, so with 4096 samples and a hop of 256 it takes about a third of
+	 * the time of difference_method::Direct, see benchmarks/yin_difference_benchmark.
+	 * difference_method::Decimated first searches a low-pass filtered copy of the buffer with only every \a yin_decimation th sample,
+	 * and then only computes the lags around the minima found there at full resolution.
+	 * If the library is built without FFT support, difference_method::Fft falls back to difference_method::Direct.
+	 */
+	difference_method yin_difference = difference_method::Direct;
+	/**
+	 * @brief The lowest note to detect
+	 *
+	 * The Midi number of the lowest note that pitch detection searches for.
+	 * The pitch detection algorithms do not even look at lower pitches, so narrowing the range also saves computation time.
+	 */
+	int min_note = MidiMin;
+	/**
+	 * @brief The highest note to detect
+	 *
+	 * The Midi number of the highest note that pitch detection searches for.
+	 * The pitch detection algorithms do not even look at higher pitches, so narrowing the range also saves computation time.
+	 */
+	int max_note = MidiMax;
+	/**
+	 * @brief The number of threads
+	 *
+	 * Some pitch detection algorithms can distribute their work across multiple threads.
+	 * The results do not depend on this number. A value of 1 does all work on the calling thread.
+	 * The threads are started once, when the pitch detector is constructed.
+	 */
+	size_t num_threads = 1;
+	/**
+	 * @brief The search width for polyphonic pitch detection
+	 *
+	 * Some polyphonic pitch detection algorithms can either try every combination of notes, which grows exponentially with \a max_polyphony,
+	 * or only keep the best \a search_width notes and combinations of each size and only extend those by further voices.
+	 * A value of 0 always tries every combination.
+	 */
+	size_t search_width = 0;
+	/**
+	 * @brief The windowing function
+	 *
+	 * This windowing function is applied to the buffer before every FFT
+	 */
+	window_type window = window_type::Welch;
+	/**
+	 * @brief A path to a fftw wisdom file
+	 *
+	 * If set, FFT plans are looked up in this file before measuring them, and newly measured plans are saved to it,
+	 * which makes constructing pitch detectors almost free in short-lived processes.
+	 * The path must not go out of scope until the pitch detection object has been constructed.
+	 */
+	const std::filesystem::path *wisdom_path = nullptr;
+	/**
+	 * @brief The method used to compute frequency spectra
+	 *
+	 * spectrum_method::Fft transforms every buffer from scratch in \f$O(n \log n)\f$.
+	 * spectrum_method::Sliding keeps the spectrum of the previous buffer and only accounts for the \a hop_size samples
+	 * that were shifted in and out, which costs \f$O(n \cdot hop)\f$ per buffer if consecutive buffers overlap.
+	 * This pays off for very small hop sizes, mostly with the bundled FFT, as fftw is fast enough to win above a hop of 16. The sliding spectrum only supports the windows window_type::Rectangular,
+	 * window_type::Hanning and window_type::Hamming, because they can be applied in the frequency domain.
+	 * Hop sizes above fft::max_sliding_hop fall back to spectrum_method::Fft, which is faster for them.
+	 */
+	spectrum_method spectrum = spectrum_method::Fft;
+	/**
+	 * @brief The decimation factor of the coarse Yin search
+	 *
+	 * This only has an effect with difference_method::Decimated, and must then be at least 1 and at most the period of the highest note in samples.
+	 * The coarse search costs about the square of this factor less than difference_method::Direct.
+	 * Lags of only few decimated samples, and the lags around the coarse minima, are still computed at full resolution.
+	 */
+	size_t yin_decimation = 4;
 
 	/**
 	 * @brief Returns the error state of this config
@@ -121,6 +237,24 @@ public:
 	 * Returns a human-readable representation of the last error.
 	 */
 	std::string error_str() const;
+	/**
+	 * @brief Checks if a note is within the searched range
+	 *
+	 * Returns \c true iff \p note lies between \a min_note and \a max_note
+	 */
+	bool note_in_range(int note) const;
+	/**
+	 * @brief Returns the lowest frequency that is searched for
+	 *
+	 * This is the frequency half a semitone below \a min_note, i.e. the lowest frequency that still rounds to \a min_note
+	 */
+	float min_frequency() const;
+	/**
+	 * @brief Returns the highest frequency that is searched for
+	 *
+	 * This is the frequency half a semitone above \a max_note, i.e. the highest frequency that still rounds to \a max_note
+	 */
+	float max_frequency() const;
 };
 
 constexpr const config yin_config {pitch_detection_method::Yin};
@@ -0,0 +1,48 @@
+#include "autocorrelation.hpp"
+#include "plan_cache.hpp"
+
+#ifdef HAS_FFT
+
+namespace fftune {
+
+autocorrelation::autocorrelation(size_t num_samples, fft_heuristic heuristic) {
+	this->num_samples = num_samples;
+	this->padded_size = 2 * num_samples;
+
+	real_buf = plan_cache::alloc_real(padded_size);
+	complex_buf = plan_cache::alloc_complex(padded_size / 2 + 1);
+
+	const auto flag = fft_heuristic_to_flag(heuristic);
+	forward = plan_cache::get(plan_kind::RealToComplex, padded_size, flag);
+	backward = plan_cache::get(plan_kind::ComplexToReal, padded_size, flag);
+}
+
+autocorrelation::~autocorrelation() {
+	// the plans are owned by the plan cache
+	plan_cache::free_buffer(real_buf);
+	plan_cache::free_buffer(complex_buf);
+}
+
+void autocorrelation::detect(const float *data, std::vector<float> &result) {
+	// the padding has to be cleared every time, because the inverse transform overwrites it
+	std::memcpy(real_buf, data, num_samples * sizeof(float));
+	std::fill(real_buf + num_samples, real_buf + padded_size, 0.f);
+
+	plan_cache::execute(forward, real_buf, complex_buf);
+	// the autocorrelation is the inverse transform of the power spectrum
+	for (size_t i = 0; i < padded_size / 2 + 1; ++i) {
+		complex_buf[i] = std::norm(complex_buf[i]);
+	}
+	plan_cache::execute(backward, complex_buf, real_buf);
+
+	// the inverse transform is not normalized
+	const float scale = 1.f / padded_size;
+	result.resize(num_samples);
+	for (size_t tau = 0; tau < num_samples; ++tau) {
+		result[tau] = real_buf[tau] * scale;
+	}
+}
+
+}
+
+#endif
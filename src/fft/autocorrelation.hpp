@@ -0,0 +1,54 @@
+#pragma once
+
+#ifdef HAS_FFT
+
+#include <vector>
+
+#include "fft.hpp"
+
+namespace fftune {
+
+/**
+ * @brief A fast autocorrelation
+ *
+ * Computes the linear autocorrelation of a buffer via the Wiener-Khinchin theorem, i.e. as the inverse FFT of the power spectrum.
+ * The buffer size must be given at creation.
+ */
+class autocorrelation {
+public:
+	autocorrelation() = delete;
+	/**
+	 * @brief Constructs an autocorrelation object
+	 *
+	 * The buffer size is set according to \p num_samples
+	 */
+	explicit autocorrelation(size_t num_samples, fft_heuristic heuristic = fft_heuristic::OptimizeRuntime);
+	autocorrelation(const autocorrelation &) = delete;
+	autocorrelation &operator=(const autocorrelation &) = delete;
+	/**
+	 * @brief Destructs an autocorrelation object
+	 *
+	 * This frees the buffers, the plans stay in the plan cache for future use.
+	 */
+	~autocorrelation();
+	/**
+	 * @brief Computes the autocorrelation
+	 *
+	 * Reads \a num_samples samples from \p data and writes
+	 * \f$r(\tau) = \sum_j x_j x_{j + \tau}\f$ for every \f$\tau < n\f$ to \p result.
+	 * No windowing function is applied.
+	 */
+	void detect(const float *data, std::vector<float> &result);
+private:
+	size_t num_samples;
+	// zero padded to twice the size, so that the circular correlation equals the linear one
+	size_t padded_size;
+	float *real_buf = nullptr;
+	std::complex<float> *complex_buf = nullptr;
+	fft_plan forward;
+	fft_plan backward;
+};
+
+}
+
+#endif
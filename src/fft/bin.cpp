@@ -1,7 +1,94 @@
 #include "bin.hpp"
 
+#include <cmath>
+#include <limits>
+
 namespace fftune {
 
+namespace {
+
+/**
+ * The sums over a window of values
+ * Infinite values, e.g. the magnitudes of silent bins, are counted separately,
+ * so that removing them from the window again does not leave the sums undefined
+ */
+struct window_sums {
+	double sum = 0.0;
+	double squares = 0.0;
+	size_t count = 0;
+	size_t negative_infinities = 0;
+	size_t positive_infinities = 0;
+
+	void add(float value, int sign) {
+		count += sign;
+		if (std::isinf(value)) {
+			(value < 0.f ? negative_infinities : positive_infinities) += sign;
+			return;
+		}
+		sum += sign * static_cast<double>(value);
+		squares += sign * static_cast<double>(value) * value;
+	}
+	float mean() const {
+		if (negative_infinities || positive_infinities) {
+			return (negative_infinities && positive_infinities) ? std::numeric_limits<float>::quiet_NaN() : (negative_infinities ? -INFINITY : INFINITY);
+		}
+		return sum / count;
+	}
+	float standard_deviation() const {
+		if (negative_infinities || positive_infinities) {
+			return std::numeric_limits<float>::quiet_NaN();
+		}
+		// rounding errors must not make the variance negative
+		return std::sqrt(std::max(0.0, (squares - sum * sum / count) / (count - 1)));
+	}
+};
+
+// calls f(i, sums) with the sums over the window of every index i
+template<typename F>
+void sliding_sums(std::span<const float> in, size_t before, size_t after, F f) {
+	window_sums sums;
+	size_t begin = 0;
+	size_t end = 0;
+	for (size_t i = 0; i < in.size(); ++i) {
+		// both ends of the window only ever move forward
+		for (; end < std::min(i + after, in.size()); ++end) {
+			sums.add(in[end], 1);
+		}
+		for (; begin + before < i; ++begin) {
+			sums.add(in[begin], -1);
+		}
+		f(i, sums);
+	}
+}
+
+// writes the value of every window, that is preferred over all others by the strict order prefer
+template<typename Compare>
+void sliding_extreme(std::span<const float> in, size_t before, size_t after, std::span<float> out, Compare prefer) {
+	/**
+	 * The indices of the window in ascending order, but only those, whose value is preferred over all values after them.
+	 * The front is therefore the extreme of the window.
+	 * Every index is added once, so a plain array is enough to hold the queue.
+	 */
+	std::vector<size_t> queue(in.size());
+	size_t head = 0;
+	size_t tail = 0;
+	size_t end = 0;
+	for (size_t i = 0; i < in.size(); ++i) {
+		for (; end < std::min(i + after, in.size()); ++end) {
+			while (tail > head && !prefer(in[queue[tail - 1]], in[end])) {
+				--tail;
+			}
+			queue[tail++] = end;
+		}
+		while (head < tail && queue[head] + before < i) {
+			++head;
+		}
+		out[i] = head < tail ? in[queue[head]] : std::numeric_limits<float>::quiet_NaN();
+	}
+}
+
+}
+
 bin::bin(float real, float img, float magnitude, float freq) {
 	value = {real, img};
 	this->magnitude = magnitude;
@@ -70,35 +157,28 @@ bins discrete_derivative(const bins &b) {
 }
 
 float bins_distance(const bins &a, const bins &b) {
-	float result = 0.f;
 	// lower value means more similar
 	constexpr int neighbors = 40;
-	for (int i = 0; i < a.size(); ++i) {
-		float mean_a = 0.f;
-		float mean_b = 0.f;
-		size_t count = 0;
-		for (int j = std::max(0, i - neighbors); j < std::min(i + 10, static_cast<int>(a.size())); ++j) {
-			mean_a += a[j].magnitude;
-			mean_b += b[j].magnitude;
-			++count;
-		}
-		mean_a /= count;
-		mean_b /= count;
-
-		float standard_deviation_a = 0.f;
-		float standard_deviation_b = 0.f;
-		for (int j = std::max(0, i - neighbors); j < std::min(i + 10, static_cast<int>(a.size())); ++j) {
-			float diff = a[j].magnitude - mean_a;
-			standard_deviation_a += diff * diff;
+	constexpr int following = 10;
+	std::vector<float> magnitudes_a(a.size());
+	std::vector<float> magnitudes_b(b.size());
+	std::ranges::transform(a, magnitudes_a.begin(), &bin::magnitude);
+	std::ranges::transform(b, magnitudes_b.begin(), &bin::magnitude);
 
-			diff = b[j].magnitude - mean_b;
-			standard_deviation_b += diff * diff;
-		}
-		standard_deviation_a = std::sqrt(standard_deviation_a / (count - 1));
-		standard_deviation_b = std::sqrt(standard_deviation_b / (count - 1));
+	// the statistics of the neighbourhood of every bin
+	std::vector<float> mean_a(a.size());
+	std::vector<float> mean_b(b.size());
+	std::vector<float> standard_deviation_a(a.size());
+	std::vector<float> standard_deviation_b(b.size());
+	sliding_mean(magnitudes_a, neighbors, following, mean_a);
+	sliding_mean(magnitudes_b, neighbors, following, mean_b);
+	sliding_standard_deviation(magnitudes_a, neighbors, following, standard_deviation_a);
+	sliding_standard_deviation(magnitudes_b, neighbors, following, standard_deviation_b);
 
-		float dev_a = (a[i].magnitude - mean_a) / standard_deviation_a;
-		float dev_b = (b[i].magnitude - mean_b) / standard_deviation_b;
+	float result = 0.f;
+	for (size_t i = 0; i < a.size(); ++i) {
+		float dev_a = (magnitudes_a[i] - mean_a[i]) / standard_deviation_a[i];
+		float dev_b = (magnitudes_b[i] - mean_b[i]) / standard_deviation_b[i];
 
 		auto delta = dev_a - dev_b;
 		result += delta * delta * delta * delta;
@@ -107,12 +187,20 @@ float bins_distance(const bins &a, const bins &b) {
 }
 
 float bins_distance_complete(const bins &a, const bins &b) {
+	std::vector<float> magnitudes_a(a.size());
+	std::vector<float> magnitudes_b(b.size());
+	std::ranges::transform(a, magnitudes_a.begin(), &bin::magnitude);
+	std::ranges::transform(b, magnitudes_b.begin(), &bin::magnitude);
+	return bins_distance_complete(magnitudes_a, magnitudes_b);
+}
+
+float bins_distance_complete(std::span<const float> a, std::span<const float> b) {
 	// compute mean
 	float mean_a = 0.f;
 	float mean_b = 0.f;
 	for (size_t i = 0; i < a.size(); ++i) {
-		mean_a += a[i].magnitude;
-		mean_b += b[i].magnitude;
+		mean_a += a[i];
+		mean_b += b[i];
 	}
 	mean_a /= a.size();
 	mean_b /= b.size();
@@ -121,10 +209,10 @@ float bins_distance_complete(const bins &a, const bins &b) {
 	float standard_deviation_a = 0.f;
 	float standard_deviation_b = 0.f;
 	for (size_t i = 0; i < a.size(); ++i) {
-		float diff = a[i].magnitude - mean_a;
+		float diff = a[i] - mean_a;
 		standard_deviation_a += diff * diff;
 
-		diff = b[i].magnitude - mean_b;
+		diff = b[i] - mean_b;
 		standard_deviation_b += diff * diff;
 	}
 	standard_deviation_a = std::sqrt(standard_deviation_a / (a.size() - 1));
@@ -133,8 +221,8 @@ float bins_distance_complete(const bins &a, const bins &b) {
 	// lower value means more similar
 	float result = 0.f;
 	for (size_t i = 0; i < a.size(); ++i) {
-		float dev_a = (a[i].magnitude - mean_a) / standard_deviation_a;
-		float dev_b = (b[i].magnitude - mean_b) / standard_deviation_b;
+		float dev_a = (a[i] - mean_a) / standard_deviation_a;
+		float dev_b = (b[i] - mean_b) / standard_deviation_b;
 
 		auto delta = dev_a - dev_b;
 		result += delta * delta * delta * delta;
@@ -149,26 +237,10 @@ void bins_normalize_pos(bins &b) {
 }
 
 void bins_normalize_sin(bins &b) {
-	const int local_width = b.size() / 300;
-	std::vector<float> magnitudes;
-	magnitudes.resize(b.size());
-	for (int i = 0; i < b.size(); ++i) {
-		// compute local mean
-		float local_mean = 0.f;
-		size_t num_locals = 0;
-		for (int j = std::max(i - local_width, 0); j < std::min(i + local_width, static_cast<int>(b.size())); ++j) {
-			local_mean += b[j].magnitude;
-			++num_locals;
-		}
-		local_mean /= num_locals;
-
-		// compute deviation
-		float max_deviation = 0.f;
-		for (int j = std::max(i - local_width, 0); j < std::min(i + local_width, static_cast<int>(b.size())); ++j) {
-			max_deviation = std::max(max_deviation, std::abs(b[j].magnitude - local_mean));
-		}
-		magnitudes[i] = (b[i].magnitude - local_mean) / max_deviation;
-	}
+	std::vector<float> in(b.size());
+	std::ranges::transform(b, in.begin(), &bin::magnitude);
+	std::vector<float> magnitudes(b.size());
+	bins_normalize_sin(in, magnitudes);
 
 	// copy magnitudes
 	for (size_t i = 0; i < b.size(); ++i) {
@@ -176,4 +248,36 @@ void bins_normalize_sin(bins &b) {
 	}
 }
 
+void bins_normalize_sin(std::span<const float> in, std::span<float> out) {
+	const size_t local_width = in.size() / 300;
+	// the mean is written to out first and then replaced by the result
+	std::vector<float> local_max(in.size());
+	std::vector<float> local_min(in.size());
+	sliding_mean(in, local_width, local_width, out);
+	sliding_max(in, local_width, local_width, local_max);
+	sliding_min(in, local_width, local_width, local_min);
+	for (size_t i = 0; i < in.size(); ++i) {
+		const auto local_mean = out[i];
+		// the largest deviation from the mean is either at the maximum or at the minimum
+		const auto max_deviation = std::max(local_max[i] - local_mean, local_mean - local_min[i]);
+		out[i] = (in[i] - local_mean) / max_deviation;
+	}
+}
+
+void sliding_mean(std::span<const float> in, size_t before, size_t after, std::span<float> out) {
+	sliding_sums(in, before, after, [&](size_t i, const window_sums &sums) { out[i] = sums.mean(); });
+}
+
+void sliding_standard_deviation(std::span<const float> in, size_t before, size_t after, std::span<float> out) {
+	sliding_sums(in, before, after, [&](size_t i, const window_sums &sums) { out[i] = sums.standard_deviation(); });
+}
+
+void sliding_max(std::span<const float> in, size_t before, size_t after, std::span<float> out) {
+	sliding_extreme(in, before, after, out, std::greater<float>());
+}
+
+void sliding_min(std::span<const float> in, size_t before, size_t after, std::span<float> out) {
+	sliding_extreme(in, before, after, out, std::less<float>());
+}
+
 }
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <complex>
 #include <ranges>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -111,6 +112,12 @@ float bins_distance(const bins &a, const bins &b);
  * This is an alternative to bins_distance
  */
 float bins_distance_complete(const bins &a, const bins &b);
+/**
+ * @brief Computes a theoretical distance between two spectra
+ *
+ * Like bins_distance_complete, but operates on the magnitudes \p a and \p b directly
+ */
+float bins_distance_complete(std::span<const float> a, std::span<const float> b);
 /**
  * @brief Normalizes bins to be only positive
  *
@@ -121,5 +128,38 @@ float bins_distance_complete(const bins &a, const bins &b);
  */
 void bins_normalize_pos(bins &b);
 void bins_normalize_sin(bins &b);
+/**
+ * @brief Normalizes magnitudes relative to their neighbourhood
+ *
+ * Like bins_normalize_sin, but reads the magnitudes \p in and writes the result to \p out, which must not overlap \p in
+ */
+void bins_normalize_sin(std::span<const float> in, std::span<float> out);
+
+/**
+ * @brief Computes the mean of every window
+ *
+ * Writes the mean of \p in within the window \f$[i - before, i + after)\f$, clipped to the bounds of \p in, to \p out for every index \c i.
+ * The windows are updated with running sums, so this takes linear time regardless of the window size.
+ */
+void sliding_mean(std::span<const float> in, size_t before, size_t after, std::span<float> out);
+/**
+ * @brief Computes the standard deviation of every window
+ *
+ * Like sliding_mean(), but writes the sample standard deviation of every window to \p out
+ */
+void sliding_standard_deviation(std::span<const float> in, size_t before, size_t after, std::span<float> out);
+/**
+ * @brief Computes the maximum of every window
+ *
+ * Like sliding_mean(), but writes the maximum of every window to \p out.
+ * The candidates for the maximum are kept in a monotonic queue, so this takes linear time regardless of the window size.
+ */
+void sliding_max(std::span<const float> in, size_t before, size_t after, std::span<float> out);
+/**
+ * @brief Computes the minimum of every window
+ *
+ * Like sliding_max(), but writes the minimum of every window to \p out
+ */
+void sliding_min(std::span<const float> in, size_t before, size_t after, std::span<float> out);
 
 }
@@ -0,0 +1,145 @@
+#include "builtin_fft.hpp"
+
+#include <bit>
+#include <cmath>
+
+namespace fftune {
+
+builtin_fft::builtin_fft(size_t size) {
+	this->size = size;
+	radix2 = size >= 4 && std::has_single_bit(size);
+	roots_re.resize(size);
+	roots_im.resize(size);
+	for (size_t j = 0; j < size; ++j) {
+		const double angle = -2.0 * M_PI * j / size;
+		roots_re[j] = std::cos(angle);
+		roots_im[j] = std::sin(angle);
+	}
+}
+
+void builtin_fft::forward(const float *in, std::complex<float> *out) const {
+	if (!radix2) {
+		direct_forward(in, out);
+		return;
+	}
+
+	// the real samples are transformed as half as many complex samples, even samples are the real parts, odd samples the imaginary parts
+	const auto m = size / 2;
+	thread_local std::vector<float> scratch;
+	scratch.resize(4 * m);
+	float *re = scratch.data();
+	float *im = re + m;
+	for (size_t j = 0; j < m; ++j) {
+		re[j] = in[2 * j];
+		im[j] = in[2 * j + 1];
+	}
+	stockham(re, im, scratch.data() + 2 * m, scratch.data() + 3 * m);
+
+	/**
+	 * Split the result into the spectra E of the even and O of the odd samples, then X_k = E_k + e^{-2 pi i k / n} O_k
+	 * where E_k = (Z_k + conj(Z_{m - k})) / 2 and O_k = (Z_k - conj(Z_{m - k})) / 2i
+	 */
+	for (size_t k = 0; k <= m; ++k) {
+		const std::complex<float> z {re[k % m], im[k % m]};
+		const std::complex<float> mirrored {re[(m - k) % m], -im[(m - k) % m]};
+		const auto even = 0.5f * (z + mirrored);
+		const auto odd = std::complex<float> {0.f, -0.5f} * (z - mirrored);
+		out[k] = even + std::complex<float> {roots_re[k], roots_im[k]} * odd;
+	}
+}
+
+void builtin_fft::inverse(const std::complex<float> *in, float *out) const {
+	if (!radix2) {
+		direct_inverse(in, out);
+		return;
+	}
+
+	// undo the split of forward(), the factor 2 of both halves accounts for transforming only half as many samples
+	const auto m = size / 2;
+	thread_local std::vector<float> scratch;
+	scratch.resize(4 * m);
+	float *re = scratch.data();
+	float *im = re + m;
+	for (size_t k = 0; k < m; ++k) {
+		const auto x = std::complex<float> {in[k].real(), (k == 0) ? 0.f : in[k].imag()};
+		const auto mirrored = std::complex<float> {in[m - k].real(), (k == 0) ? 0.f : -in[m - k].imag()};
+		const auto even = x + mirrored;
+		const auto odd = (x - mirrored) * std::complex<float> {roots_re[k], -roots_im[k]};
+		// the inverse transformation is a forward transformation of the complex conjugate
+		const auto z = std::conj(even + std::complex<float> {0.f, 1.f} * odd);
+		re[k] = z.real();
+		im[k] = z.imag();
+	}
+	stockham(re, im, scratch.data() + 2 * m, scratch.data() + 3 * m);
+	for (size_t j = 0; j < m; ++j) {
+		out[2 * j] = re[j];
+		out[2 * j + 1] = -im[j];
+	}
+}
+
+void builtin_fft::stockham(float *&re, float *&im, float *re_scratch, float *im_scratch) const {
+	/**
+	 * Every stage splits the sequences of length len into two of half the length,
+	 * writing the result to the other buffer in an order that needs no bit reversal at the end.
+	 * The innermost loop runs over contiguous memory.
+	 */
+	const auto m = size / 2;
+	for (size_t len = m, stride = 1; len > 1; len /= 2, stride *= 2) {
+		const auto half = len / 2;
+		for (size_t p = 0; p < half; ++p) {
+			// e^{-2 pi i p / len}
+			const float w_re = roots_re[2 * p * stride];
+			const float w_im = roots_im[2 * p * stride];
+			const float *a_re = re + stride * p;
+			const float *a_im = im + stride * p;
+			const float *b_re = re + stride * (p + half);
+			const float *b_im = im + stride * (p + half);
+			float *sum_re = re_scratch + stride * 2 * p;
+			float *sum_im = im_scratch + stride * 2 * p;
+			float *diff_re = re_scratch + stride * (2 * p + 1);
+			float *diff_im = im_scratch + stride * (2 * p + 1);
+			for (size_t q = 0; q < stride; ++q) {
+				const float d_re = a_re[q] - b_re[q];
+				const float d_im = a_im[q] - b_im[q];
+				sum_re[q] = a_re[q] + b_re[q];
+				sum_im[q] = a_im[q] + b_im[q];
+				diff_re[q] = d_re * w_re - d_im * w_im;
+				diff_im[q] = d_re * w_im + d_im * w_re;
+			}
+		}
+		std::swap(re, re_scratch);
+		std::swap(im, im_scratch);
+	}
+}
+
+void builtin_fft::direct_forward(const float *in, std::complex<float> *out) const {
+	for (size_t k = 0; k <= size / 2; ++k) {
+		std::complex<double> sum = 0.0;
+		size_t index = 0;
+		for (size_t j = 0; j < size; ++j) {
+			sum += static_cast<double>(in[j]) * std::complex<double> {roots_re[index], roots_im[index]};
+			// index is j * k modulo size
+			index = (index + k) % size;
+		}
+		out[k] = std::complex<float>(sum);
+	}
+}
+
+void builtin_fft::direct_inverse(const std::complex<float> *in, float *out) const {
+	// the missing half of the spectrum is the complex conjugate of the given half
+	for (size_t j = 0; j < size; ++j) {
+		double sum = in[0].real();
+		size_t index = 0;
+		for (size_t k = 1; k < (size + 1) / 2; ++k) {
+			index = (index + j) % size;
+			// Re(X_k * e^{2 pi i j k / size}), counted twice for the mirrored value
+			sum += 2.0 * (in[k].real() * roots_re[index] + in[k].imag() * roots_im[index]);
+		}
+		if (size % 2 == 0) {
+			sum += (j % 2 == 0) ? in[size / 2].real() : -in[size / 2].real();
+		}
+		out[j] = sum;
+	}
+}
+
+}
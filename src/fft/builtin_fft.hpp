@@ -0,0 +1,52 @@
+#pragma once
+
+#include <complex>
+#include <vector>
+
+namespace fftune {
+
+/**
+ * @brief A bundled real FFT
+ *
+ * This is a self-contained FFT, that is used if the library is built without fftw.
+ * Power-of-two sizes are transformed with a radix-2 Stockham FFT of half the size
+ * on separate arrays for the real and imaginary parts, so that the compiler can vectorize all butterflies.
+ * All other sizes fall back to a direct DFT.
+ *
+ * Just like fftw, no transformation is normalized, so a forward and an inverse transformation scale the samples by the size.
+ * Transforming is thread-safe.
+ */
+class builtin_fft {
+public:
+	builtin_fft() = delete;
+	/**
+	 * @brief Constructs a builtin_fft object
+	 *
+	 * Prepares a transformation of \p size real samples
+	 */
+	explicit builtin_fft(size_t size);
+	/**
+	 * @brief Performs a forward transformation
+	 *
+	 * Reads \a size samples from \p in and writes \f$\frac{size}{2} + 1\f$ values to \p out
+	 */
+	void forward(const float *in, std::complex<float> *out) const;
+	/**
+	 * @brief Performs an inverse transformation
+	 *
+	 * Reads \f$\frac{size}{2} + 1\f$ values from \p in and writes \a size samples to \p out.
+	 * The imaginary parts of the first and the last value are ignored.
+	 */
+	void inverse(const std::complex<float> *in, float *out) const;
+private:
+	void stockham(float *&re, float *&im, float *re_scratch, float *im_scratch) const;
+	void direct_forward(const float *in, std::complex<float> *out) const;
+	void direct_inverse(const std::complex<float> *in, float *out) const;
+	size_t size;
+	bool radix2;
+	// e^{-2 pi i j / size} for every j < size
+	std::vector<float> roots_re;
+	std::vector<float> roots_im;
+};
+
+}
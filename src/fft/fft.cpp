@@ -1,12 +1,17 @@
 #include "fft.hpp"
 
-#ifdef HAS_FFTW3F
+#ifdef HAS_FFT
 
+#include "autocorrelation.hpp"
+#include "plan_cache.hpp"
 #include "window.hpp"
 
+#include <unistd.h>
+
 namespace fftune {
 
-int fft_heuristic_to_flag(fft_heuristic heuristic) {
+int fft_heuristic_to_flag([[maybe_unused]] fft_heuristic heuristic) {
+#ifdef HAS_FFTW3F
 	switch (heuristic) {
 	case fft_heuristic::OptimizeRuntime:
 		return FFTW_MEASURE;
@@ -15,45 +20,199 @@ int fft_heuristic_to_flag(fft_heuristic heuristic) {
 	default:
 		return FFTW_MEASURE;
 	}
+#else
+	// the bundled FFT has nothing to measure
+	return 0;
+#endif
 }
 
+#ifdef HAS_FFTW3F
+
+bool fft_import_wisdom(const std::filesystem::path &path) {
+	const auto lock = plan_cache::lock_planner();
+	return fftwf_import_wisdom_from_filename(path.c_str());
+}
 
-fft::fft(size_t num_samples, float sample_rate, fft_heuristic heuristic) {
+bool fft_export_wisdom(const std::filesystem::path &path) {
+	// write to a private file first and then move it into place
+	auto tmp_path = path;
+	tmp_path += ".tmp" + std::to_string(getpid());
+	{
+		const auto lock = plan_cache::lock_planner();
+		if (!fftwf_export_wisdom_to_filename(tmp_path.c_str())) {
+			return false;
+		}
+	}
+	std::error_code err;
+	std::filesystem::rename(tmp_path, path, err);
+	return !err;
+}
+
+bool fft_generate_wisdom(const std::vector<size_t> &sizes, const std::filesystem::path &path) {
+	// keep the existing wisdom
+	fft_import_wisdom(path);
+	for (const auto size : sizes) {
+		// constructing the objects measures all plans that the pitch detection algorithms need
+		fft spectrum {size, 1.f};
+		autocorrelation acf {size};
+		plan_cache::get(plan_kind::RealToComplex, size, fft_heuristic_to_flag(fft_heuristic::OptimizeRuntime), fft::max_batch);
+	}
+	return fft_export_wisdom(path);
+}
+#endif
+
+fft::fft(size_t num_samples, float sample_rate, fft_heuristic heuristic, window_type window) {
 	this->num_samples = num_samples;
 	this->sample_rate = sample_rate;
+	window_weights = window::table(window, num_samples).data();
 
 	// in has n elements, out has n/2+1 elements
-	in_buf = fftwf_alloc_real(num_samples);
-	out_buf = fftwf_alloc_complex(num_samples);
+	in_buf = plan_cache::alloc_real(num_samples);
+	out_buf = plan_cache::alloc_complex(num_samples);
+
+	flags = fft_heuristic_to_flag(heuristic);
+	plan = plan_cache::get(plan_kind::RealToComplex, num_samples, flags);
 
-	plan = fftwf_plan_dft_r2c_1d(num_samples, in_buf, out_buf, fft_heuristic_to_flag(heuristic));
+	// the frequencies never change
+	result.resize(bins_size());
+	for (size_t i = 0; i < bins_size(); ++i) {
+		result.frequencies[i] = sample_rate / num_samples * i;
+	}
 }
 
-fft::~fft() {
-	fftwf_destroy_plan(plan);
+fft::fft(const config &conf, fft_heuristic heuristic)
+	: fft(conf.buffer_size, conf.sample_rate, heuristic, conf.window) {
+	// anything the sliding spectrum can not handle, or where it does not pay off, falls back to full transformations
+	if (conf.spectrum == spectrum_method::Sliding && conf.hop_size <= max_sliding_hop && conf.hop_size < conf.buffer_size && sliding_dft::supported(conf.window)) {
+		sliding = std::make_unique<sliding_dft>(conf.buffer_size, conf.hop_size, conf.window);
+		sliding_hop = conf.hop_size;
+	} else {
+		// plan batches right away, so that the plan is measured before a pitch_detector saves its wisdom
+		prepare_batches();
+	}
+}
 
-	fftwf_free(in_buf);
-	fftwf_free(out_buf);
+fft::~fft() {
+	// the plan is owned by the plan cache
+	plan_cache::free_buffer(in_buf);
+	plan_cache::free_buffer(out_buf);
+	plan_cache::free_buffer(batch_in);
+	plan_cache::free_buffer(batch_out);
 }
 
 bins fft::detect(const sample_buffer &buf) {
-	// first copy buffer so that we do not overwrite the input
-	buf.write(in_buf);
-	// apply windowing function
-	window::default_window(in_buf, num_samples);
+	return detect_spectrum(buf).to_bins();
+}
 
-	fftwf_execute(plan);
-	bins result;
-	for (size_t i = 0; i < bins_size(); ++i) {
-		result.push_back({out_buf[i][0], out_buf[i][1], i, num_samples, sample_rate});
-	}
+const spectrum_buffer &fft::detect_spectrum(const sample_buffer &buf) {
+	// our frequencies have been computed at construction
+	detect(buf, result, {.frequencies = false});
 	return result;
 }
 
+void fft::detect(const sample_buffer &buf, spectrum_buffer &result, spectrum_fields fields) {
+	transform(buf.data);
+	convert(out_buf, result, fields);
+}
+
+void fft::detect(const float *samples, size_t num_frames, size_t hop_size, std::span<spectrum_buffer> result, spectrum_fields fields) {
+	if (sliding) {
+		// sliding from one frame to the next is already cheaper than any batch
+		for (size_t frame = 0; frame < num_frames; ++frame) {
+			const auto *frame_samples = samples + frame * hop_size;
+			// the frames of a call continue each other, so only the first one has to be compared to the last buffer
+			slide(frame_samples, frame > 0 ? hop_size == sliding_hop : sliding->continues(frame_samples));
+			convert(out_buf, result[frame], fields);
+		}
+		if (num_frames > 0) {
+			sliding->remember(samples + (num_frames - 1) * hop_size);
+		}
+		return;
+	}
+	prepare_batches();
+	size_t first = 0;
+	for (; first + max_batch <= num_frames; first += max_batch) {
+		for (size_t frame = 0; frame < max_batch; ++frame) {
+			window::apply(samples + (first + frame) * hop_size, batch_in + frame * num_samples, window_weights, num_samples);
+		}
+		plan_cache::execute(batch_plan, batch_in, batch_out);
+		for (size_t frame = 0; frame < max_batch; ++frame) {
+			convert(batch_out + frame * bins_size(), result[first + frame], fields);
+		}
+	}
+	// the remaining frames do not fill a batch, a plan for every possible count would have to be measured on its own
+	for (; first < num_frames; ++first) {
+		transform(samples + first * hop_size);
+		convert(out_buf, result[first], fields);
+	}
+}
+
+void fft::prepare_batches() {
+	if (!batch_plan) {
+		batch_in = plan_cache::alloc_real(num_samples * max_batch);
+		batch_out = plan_cache::alloc_complex(bins_size() * max_batch);
+		batch_plan = plan_cache::get(plan_kind::RealToComplex, num_samples, flags, max_batch);
+	}
+}
+
+void fft::transform(const float *samples) {
+	if (!sliding) {
+		// copy the buffer and apply the windowing function in a single pass, so that we do not overwrite the input
+		window::apply(samples, in_buf, window_weights, num_samples);
+		plan_cache::execute(plan, in_buf, out_buf);
+		return;
+	}
+
+	slide(samples, sliding->continues(samples));
+	sliding->remember(samples);
+}
+
+void fft::slide(const float *samples, bool continues) {
+	if (!continues || !sliding->slide(samples)) {
+		// the sliding spectrum is unwindowed, so start over from a plain transformation
+		std::memcpy(in_buf, samples, num_samples * sizeof(float));
+		plan_cache::execute(plan, in_buf, out_buf);
+		sliding->reset(samples, out_buf);
+	}
+	sliding->spectrum(out_buf);
+}
+
+void fft::convert(const std::complex<float> *values, spectrum_buffer &result, spectrum_fields fields) const {
+	const auto size = bins_size();
+	result.resize(size);
+	for (size_t i = 0; i < size; ++i) {
+		result.values[i] = values[i];
+	}
+	if (fields.magnitudes) {
+		for (size_t i = 0; i < size; ++i) {
+			result.magnitudes[i] = 20.f * log10(2.f * std::abs(result.values[i]) / num_samples);
+		}
+	}
+	if (fields.powers) {
+		// normalized like the magnitudes, but without the logarithm
+		const float scale = 4.f / (static_cast<float>(num_samples) * num_samples);
+		for (size_t i = 0; i < size; ++i) {
+			result.powers[i] = scale * std::norm(result.values[i]);
+		}
+	}
+	if (fields.frequencies) {
+		for (size_t i = 0; i < size; ++i) {
+			result.frequencies[i] = sample_rate / num_samples * i;
+		}
+	}
+}
+
 size_t fft::bins_size() const {
 	return num_samples / 2 + 1;
 }
 
+std::pair<size_t, size_t> fft::bins_range(const config &conf) const {
+	const float resolution = sample_rate / num_samples;
+	const size_t first = std::ceil(conf.min_frequency() / resolution);
+	const size_t last = std::floor(conf.max_frequency() / resolution) + 1;
+	return {std::min(first, bins_size()), std::min(last, bins_size())};
+}
+
 }
 
 #endif
@@ -1,14 +1,19 @@
 #pragma once
 
-#ifdef HAS_FFTW3F
+#ifdef HAS_FFT
 
+#include <algorithm>
 #include <cstring>
+#include <memory>
+#include <span>
 #include <vector>
 
-#include <fftw3.h>
-
 #include "bin.hpp"
 #include "config.hpp"
+#include "peaks.hpp"
+#include "plan_cache.hpp"
+#include "sliding_dft.hpp"
+#include "spectrum_buffer.hpp"
 #include "pitch/pitch.hpp"
 
 namespace fftune {
@@ -28,11 +33,38 @@ enum class fft_heuristic {
  * Returns a flag, that can be used when creating a fftw plan.
  */
 int fft_heuristic_to_flag(fft_heuristic heuristic);
+#ifdef HAS_FFTW3F
+/**
+ * @brief Imports fftw wisdom
+ *
+ * Loads previously measured FFT plans from the wisdom file at \p path.
+ * Returns \c false if the file could not be read.
+ */
+bool fft_import_wisdom(const std::filesystem::path &path);
+/**
+ * @brief Exports fftw wisdom
+ *
+ * Saves all FFT plans measured so far to the wisdom file at \p path.
+ * The file is replaced atomically, so that concurrent processes never read a partially written file.
+ * Returns \c false if the file could not be written.
+ */
+bool fft_export_wisdom(const std::filesystem::path &path);
+/**
+ * @brief Generates fftw wisdom
+ *
+ * Measures the plans needed for every buffer size in \p sizes and adds them to the wisdom file at \p path.
+ * Returns \c false if the file could not be written.
+ */
+bool fft_generate_wisdom(const std::vector<size_t> &sizes, const std::filesystem::path &path);
+#endif
 
 /**
  * @brief A fast fourier transformation
  *
  * This object can perform a FFT. The buffer size and sample rate must be given at creation.
+ *
+ * The plan is shared with all other fft objects of the same size, see plan_cache,
+ * so fft objects can be constructed from any thread and constructing further objects of the same size is cheap.
  */
 class fft {
 public:
@@ -40,13 +72,24 @@ public:
 	/**
 	 * @brief Constructs a fft object
 	 *
-	 * The buffer size is set according to \p num_samples, the sample rate is given via \p sample_rate
+	 * The buffer size is set according to \p num_samples, the sample rate is given via \p sample_rate.
+	 * The windowing function \p window is applied to every buffer before the transformation.
+	 */
+	fft(size_t num_samples, float sample_rate, fft_heuristic heuristic = fft_heuristic::OptimizeRuntime, window_type window = window_type::Welch);
+	/**
+	 * @brief Constructs a fft object
+	 *
+	 * Buffer size, sample rate and windowing function are taken from \p conf.
+	 * If config::spectrum is spectrum_method::Sliding, buffers that continue the previous one by config::hop_size samples
+	 * are transformed with a sliding_dft instead of from scratch.
 	 */
-	fft(size_t num_samples, float sample_rate, fft_heuristic heuristic = fft_heuristic::OptimizeRuntime);
+	explicit fft(const config &conf, fft_heuristic heuristic = fft_heuristic::OptimizeRuntime);
+	fft(const fft &) = delete;
+	fft &operator=(const fft &) = delete;
 	/**
 	 * @brief Destructs a fft object
 	 *
-	 * This destroys the plan, but note that fftw may be caching the plan for future use.
+	 * This frees the buffers, the plan stays in the plan cache for future use.
 	 */
 	~fft();
 	/**
@@ -56,18 +99,113 @@ public:
 	 * Note that \p buf must be large enough to hold \a num_samples samples
 	 */
 	bins detect(const sample_buffer &buf);
+	/**
+	 * @brief Performs a FFT on a given buffer
+	 *
+	 * Reads samples from \p buf and returns the result of the FFT.
+	 * The result is owned by this object and is overwritten by the next call, so no allocation takes place.
+	 * Note that \p buf must be large enough to hold \a num_samples samples
+	 */
+	const spectrum_buffer &detect_spectrum(const sample_buffer &buf);
+	/**
+	 * @brief Performs a FFT on a given buffer
+	 *
+	 * Reads samples from \p buf and writes the result of the FFT to \p result, which is resized if necessary.
+	 * Only the quantities selected by \p fields are computed, the others are left untouched.
+	 * Reusing \p result for every call avoids any allocation.
+	 * Note that \p buf must be large enough to hold \a num_samples samples
+	 */
+	void detect(const sample_buffer &buf, spectrum_buffer &result, spectrum_fields fields = {});
+	/**
+	 * @brief Performs a FFT on multiple frames at once
+	 *
+	 * Transforms \p num_frames frames of \a num_samples samples each, that start \p hop_size samples apart in \p samples,
+	 * and writes the spectrum of every frame to the corresponding element of \p result.
+	 * The frames are transformed in batches of max_batch frames with a single call,
+	 * which is much faster than transforming them one by one. Only the remaining frames are transformed one by one.
+	 * Note that \p samples must hold \f$(num\_frames - 1) \cdot hop\_size + num\_samples\f$ samples
+	 * and \p result must hold at least \p num_frames spectra.
+	 */
+	void detect(const float *samples, size_t num_frames, size_t hop_size, std::span<spectrum_buffer> result, spectrum_fields fields = {});
+	/**
+	 * @brief Performs a FFT on multiple frames at once and visits their spectra
+	 *
+	 * Transforms the frames like the above, in batches of up to max_batch frames,
+	 * and calls \p f with the index of every frame, its spectrum and the spectrum of the frame before it.
+	 * The spectrum before is \c nullptr for the first frame and if the frames do not overlap.
+	 * Both spectra are owned by this object and are only valid during the call.
+	 */
+	template<typename F>
+	void for_each_spectrum(const float *samples, size_t num_frames, size_t hop_size, F f, spectrum_fields fields = {}) {
+		// the phase advance between overlapping frames tells the frequencies more accurately than a single spectrum
+		const bool overlap = hop_size < num_samples;
+		batch_spectra.resize(max_batch);
+		for (size_t first = 0; first < num_frames; first += max_batch) {
+			const auto count = std::min(max_batch, num_frames - first);
+			detect(samples + first * hop_size, count, hop_size, batch_spectra, fields);
+			for (size_t frame = 0; frame < count; ++frame) {
+				const auto *before = frame > 0 ? &batch_spectra[frame - 1] : (first > 0 ? &last_spectrum : nullptr);
+				f(first + frame, batch_spectra[frame], overlap ? before : nullptr);
+			}
+			// the next batch overwrites all spectra, so keep the last one
+			std::swap(last_spectrum, batch_spectra[count - 1]);
+		}
+	}
 	/**
 	 * @brief Returns the size of the bins returned from a FFT
 	 *
 	 * This is equal to \f$\frac{n}{2} + 1\f$, where \c n is \a num_samples
 	 */
 	size_t bins_size() const;
+	/**
+	 * @brief Returns the bins within the note range of a config
+	 *
+	 * Returns the half-open interval of bin indices, whose frequencies lie between
+	 * config::min_frequency() and config::max_frequency() of \p conf
+	 */
+	std::pair<size_t, size_t> bins_range(const config &conf) const;
+	/**
+	 * @brief The maximum number of frames transformed in a single batch
+	 *
+	 * This bounds the memory used for batched transformations
+	 */
+	static constexpr const size_t max_batch = 16;
+	/**
+	 * @brief The largest hop size, for which a sliding spectrum is used
+	 *
+	 * With larger hops, updating the spectrum costs more than transforming it from scratch,
+	 * so spectrum_method::Sliding falls back to full transformations.
+	 * The update costs about 0.2 us per hop sample for 4096 samples, compared to about 28 us for a transformation
+	 * with the bundled FFT, see benchmarks/sliding_benchmark. fftw transforms such a buffer in a few microseconds,
+	 * so sliding only pays off for much smaller hops with it.
+	 */
+#ifdef HAS_FFTW3F
+	static constexpr const size_t max_sliding_hop = 16;
+#else
+	static constexpr const size_t max_sliding_hop = 64;
+#endif
 private:
+	void prepare_batches();
+	void transform(const float *samples);
+	void slide(const float *samples, bool continues);
+	void convert(const std::complex<float> *values, spectrum_buffer &result, spectrum_fields fields) const;
 	size_t num_samples;
 	float sample_rate;
+	int flags;
+	const float *window_weights = nullptr;
 	float *in_buf = nullptr;
-	fftwf_complex *out_buf = nullptr;
-	fftwf_plan plan;
+	std::complex<float> *out_buf = nullptr;
+	fft_plan plan;
+	// planned at construction for a config, otherwise on the first batched transformation
+	fft_plan batch_plan = nullptr;
+	float *batch_in = nullptr;
+	std::complex<float> *batch_out = nullptr;
+	std::unique_ptr<sliding_dft> sliding;
+	size_t sliding_hop = 0;
+	spectrum_buffer result;
+	// the spectra of for_each_spectrum(), and the last one of the previous batch
+	std::vector<spectrum_buffer> batch_spectra;
+	spectrum_buffer last_spectrum;
 };
 
 }
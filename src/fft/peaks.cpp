@@ -0,0 +1,28 @@
+#include "peaks.hpp"
+
+namespace fftune {
+
+void find_peaks(const spectrum_buffer &spectrum, size_t first, size_t last, spectral_peaks &result) {
+	find_peaks(spectrum, nullptr, 0, first, last, result);
+}
+
+void find_peaks(const spectrum_buffer &spectrum, const spectrum_buffer *previous, size_t hop_size, size_t first, size_t last, spectral_peaks &result) {
+	result.clear();
+	const auto &magnitudes = spectrum.magnitudes;
+	// both neighbours are needed to tell a maximum, the outermost bins of the spectrum never qualify
+	for (size_t i = std::max<size_t>(first, 1); i < std::min(last, spectrum.size() - 1); ++i) {
+		const auto left = magnitudes[i - 1];
+		const auto center = magnitudes[i];
+		const auto right = magnitudes[i + 1];
+		if (!(center > left && center >= right)) {
+			continue;
+		}
+		const auto offset = spectrum.peak_offset(i);
+		// the vertex of the parabola through the three magnitudes, if there is one
+		const auto magnitude = offset == 0.f ? center : center - 0.25f * (left - right) * offset;
+		const auto frequency = previous ? spectrum.phase_frequency(*previous, i, hop_size) : spectrum.interpolated_frequency(i);
+		result.push_back({frequency, magnitude, i});
+	}
+}
+
+}
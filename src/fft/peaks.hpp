@@ -0,0 +1,49 @@
+#pragma once
+
+#include "spectrum_buffer.hpp"
+
+namespace fftune {
+
+/**
+ * @brief A peak of a frequency spectrum
+ *
+ * This is a local maximum of the magnitudes, with its position interpolated between the bins
+ */
+struct spectral_peak {
+	/**
+	 * @brief The interpolated frequency
+	 */
+	float frequency = 0.f;
+	/**
+	 * @brief The interpolated magnitude in decibel
+	 */
+	float magnitude = 0.f;
+	/**
+	 * @brief The index of the bin holding the maximum
+	 */
+	size_t index = 0;
+};
+/**
+ * @brief A list of spectral peaks
+ *
+ * This is a sparse representation of a spectrum, holding only its local maxima
+ */
+using spectral_peaks = std::vector<spectral_peak>;
+/**
+ * @brief Finds the peaks of a spectrum
+ *
+ * Replaces the content of \p result with all local maxima of the magnitudes of \p spectrum, whose bin index lies in [\p first, \p last),
+ * in ascending order of frequency. The position of every peak is refined by fitting a parabola through the logarithmic magnitudes of its neighbours,
+ * see spectrum_buffer::interpolated_frequency().
+ * Reusing \p result for every call avoids any allocation.
+ */
+void find_peaks(const spectrum_buffer &spectrum, size_t first, size_t last, spectral_peaks &result);
+/**
+ * @brief Finds the peaks of a spectrum
+ *
+ * Like the above, but the frequency of every peak is estimated from its phase advance since the spectrum \p previous of the buffer \p hop_size samples earlier,
+ * see spectrum_buffer::phase_frequency(). If \p previous is \c nullptr, this falls back to the interpolated frequency.
+ */
+void find_peaks(const spectrum_buffer &spectrum, const spectrum_buffer *previous, size_t hop_size, size_t first, size_t last, spectral_peaks &result);
+
+}
@@ -0,0 +1,140 @@
+#include "plan_cache.hpp"
+
+#ifdef HAS_FFT
+
+#include <cstdlib>
+#include <map>
+#include <tuple>
+#include <utility>
+
+namespace fftune {
+
+namespace {
+
+std::mutex planner_mutex;
+#ifdef HAS_FFTW3F
+// whether plans have been created since the last plan_cache::take_new_plans()
+bool new_plans = false;
+#endif
+
+}
+
+std::unique_lock<std::mutex> plan_cache::lock_planner() {
+	return std::unique_lock {planner_mutex};
+}
+
+#ifdef HAS_FFTW3F
+
+fft_plan plan_cache::get(plan_kind kind, size_t size, int flags, size_t howmany) {
+	static std::map<std::tuple<plan_kind, size_t, int, size_t>, fftwf_plan> plans;
+
+	const auto lock = lock_planner();
+	auto [it, inserted] = plans.try_emplace({kind, size, flags, howmany}, nullptr);
+	if (inserted) {
+		new_plans = true;
+		/**
+		 * Measuring a plan overwrites the arrays, so plan on scratch arrays.
+		 * They can be freed right away, because the plan is only ever executed on other arrays.
+		 */
+		const int n = size;
+		const int complex_size = size / 2 + 1;
+		auto *real_buf = fftwf_alloc_real(size * howmany);
+		auto *complex_buf = fftwf_alloc_complex(complex_size * howmany);
+		if (howmany > 1) {
+			// the arrays are contiguous, so every array starts right after the previous one
+			if (kind == plan_kind::RealToComplex) {
+				it->second = fftwf_plan_many_dft_r2c(1, &n, howmany, real_buf, nullptr, 1, n, complex_buf, nullptr, 1, complex_size, flags);
+			} else {
+				it->second = fftwf_plan_many_dft_c2r(1, &n, howmany, complex_buf, nullptr, 1, complex_size, real_buf, nullptr, 1, n, flags);
+			}
+		} else if (kind == plan_kind::RealToComplex) {
+			it->second = fftwf_plan_dft_r2c_1d(size, real_buf, complex_buf, flags);
+		} else {
+			it->second = fftwf_plan_dft_c2r_1d(size, complex_buf, real_buf, flags);
+		}
+		fftwf_free(real_buf);
+		fftwf_free(complex_buf);
+	}
+	return it->second;
+}
+
+void plan_cache::execute(fft_plan plan, float *in, std::complex<float> *out) {
+	// fftwf_complex is binary compatible to std::complex<float>
+	fftwf_execute_dft_r2c(plan, in, reinterpret_cast<fftwf_complex *>(out));
+}
+
+void plan_cache::execute(fft_plan plan, std::complex<float> *in, float *out) {
+	fftwf_execute_dft_c2r(plan, reinterpret_cast<fftwf_complex *>(in), out);
+}
+
+bool plan_cache::take_new_plans() {
+	const auto lock = lock_planner();
+	return std::exchange(new_plans, false);
+}
+
+float *plan_cache::alloc_real(size_t size) {
+	return fftwf_alloc_real(size);
+}
+
+std::complex<float> *plan_cache::alloc_complex(size_t size) {
+	return reinterpret_cast<std::complex<float> *>(fftwf_alloc_complex(size));
+}
+
+void plan_cache::free_buffer(void *data) {
+	fftwf_free(data);
+}
+
+#else
+
+fft_plan plan_cache::get(plan_kind kind, size_t size, [[maybe_unused]] int flags, size_t howmany) {
+	// map nodes never move, so the plans stay valid
+	static std::map<std::tuple<plan_kind, size_t, size_t>, builtin_plan> plans;
+
+	const auto lock = lock_planner();
+	auto it = plans.find({kind, size, howmany});
+	if (it == plans.end()) {
+		// the bundled FFT does not measure anything, so the flags do not matter
+		it = plans.emplace(std::tuple {kind, size, howmany}, builtin_plan {kind, size, howmany, builtin_fft {size}}).first;
+	}
+	return &it->second;
+}
+
+void plan_cache::execute(fft_plan plan, float *in, std::complex<float> *out) {
+	for (size_t i = 0; i < plan->howmany; ++i) {
+		plan->transform.forward(in + i * plan->size, out + i * (plan->size / 2 + 1));
+	}
+}
+
+void plan_cache::execute(fft_plan plan, std::complex<float> *in, float *out) {
+	for (size_t i = 0; i < plan->howmany; ++i) {
+		plan->transform.inverse(in + i * (plan->size / 2 + 1), out + i * plan->size);
+	}
+}
+
+namespace {
+
+// the same alignment as fftw, so that the compiler can use any vector instructions
+constexpr const size_t alignment = 64;
+
+void *alloc_aligned(size_t bytes) {
+	return std::aligned_alloc(alignment, (bytes + alignment - 1) / alignment * alignment);
+}
+
+}
+
+float *plan_cache::alloc_real(size_t size) {
+	return static_cast<float *>(alloc_aligned(size * sizeof(float)));
+}
+
+std::complex<float> *plan_cache::alloc_complex(size_t size) {
+	return static_cast<std::complex<float> *>(alloc_aligned(size * sizeof(std::complex<float>)));
+}
+
+void plan_cache::free_buffer(void *data) {
+	std::free(data);
+}
+
+#endif
+}
+
+#endif
@@ -0,0 +1,127 @@
+#pragma once
+
+#ifdef HAS_FFT
+
+#include <complex>
+#include <mutex>
+
+#ifdef HAS_FFTW3F
+#include <fftw3.h>
+#else
+#include "builtin_fft.hpp"
+#endif
+
+namespace fftune {
+
+/**
+ * @brief The kind of a FFT plan
+ *
+ * This describes the direction of a real FFT
+ */
+enum class plan_kind {
+	RealToComplex,
+	ComplexToReal,
+};
+
+#ifdef HAS_FFTW3F
+/**
+ * @brief A FFT plan
+ *
+ * This is a fftw plan
+ */
+using fft_plan = fftwf_plan;
+#else
+/**
+ * @brief A plan of the bundled FFT
+ *
+ * This transforms \a howmany contiguous arrays at once with \a transform
+ */
+struct builtin_plan {
+	plan_kind kind;
+	size_t size;
+	size_t howmany;
+	builtin_fft transform;
+};
+/**
+ * @brief A FFT plan
+ *
+ * This is a plan of the bundled FFT
+ */
+using fft_plan = const builtin_plan *;
+#endif
+
+/**
+ * @brief A process-wide cache of FFT plans
+ *
+ * The fftw planner is not thread-safe, so every plan is created here behind a mutex
+ * and then shared by all objects, that need a plan of the same kind, size and flags.
+ * Cached plans live until the program exits.
+ * If the library is built without fftw, the plans of the bundled FFT are cached the same way and the flags are ignored.
+ *
+ * Plans are created for out-of-place transforms on arrays allocated by alloc_real() and alloc_complex(),
+ * and must be executed with execute() on such arrays.
+ * Executing plans is thread-safe.
+ */
+namespace plan_cache {
+
+/**
+ * @brief Returns a cached plan
+ *
+ * Returns a plan of the given \p kind for a transformation of \p size real samples, planned with the fftw \p flags.
+ * The plan is only created on the first request.
+ *
+ * If \p howmany is greater than one, the plan transforms that many contiguous arrays at once.
+ * The real arrays are then \p size samples apart, the complex arrays \f$\frac{size}{2} + 1\f$ values.
+ */
+fft_plan get(plan_kind kind, size_t size, int flags, size_t howmany = 1);
+/**
+ * @brief Executes a real to complex plan
+ *
+ * Transforms the real samples \p in and writes the result to \p out
+ */
+void execute(fft_plan plan, float *in, std::complex<float> *out);
+/**
+ * @brief Executes a complex to real plan
+ *
+ * Transforms the complex values \p in and writes the result to \p out, \p in may be overwritten
+ */
+void execute(fft_plan plan, std::complex<float> *in, float *out);
+/**
+ * @brief Allocates real samples
+ *
+ * Returns an array of \p size samples, that is suitably aligned for execute().
+ * The array must be freed with free_buffer().
+ */
+float *alloc_real(size_t size);
+/**
+ * @brief Allocates complex values
+ *
+ * Returns an array of \p size values, that is suitably aligned for execute().
+ * The array must be freed with free_buffer().
+ */
+std::complex<float> *alloc_complex(size_t size);
+/**
+ * @brief Frees an array
+ *
+ * Frees \p data, which has been allocated by alloc_real() or alloc_complex()
+ */
+void free_buffer(void *data);
+/**
+ * @brief Locks the planner
+ *
+ * Everything that accesses the fftw planner, including its wisdom, must hold this lock.
+ */
+std::unique_lock<std::mutex> lock_planner();
+#ifdef HAS_FFTW3F
+/**
+ * @brief Checks for new plans
+ *
+ * Returns \c true if plans have been created since the last call, i.e. if the fftw wisdom may have grown.
+ */
+bool take_new_plans();
+#endif
+
+}
+}
+
+#endif
@@ -0,0 +1,138 @@
+#include "sliding_dft.hpp"
+
+#include <cassert>
+#include <cstring>
+
+#include "window.hpp"
+#include "util/simd.hpp"
+
+namespace fftune {
+
+/**
+ * The phase of every bin is advanced by repeated multiplication within a group of this many shifted samples,
+ * every group starts over from an exact phase, so that rounding errors can not accumulate
+ */
+constexpr const size_t phase_interval = 32;
+
+sliding_dft::sliding_dft(size_t num_samples, size_t hop_size, window_type window) {
+	this->num_samples = num_samples;
+	this->hop_size = hop_size;
+	[[maybe_unused]] const bool cosine = window::cosine_coefficients(window, a0, a1);
+	assert(cosine);
+
+	const size_t size = num_samples / 2 + 1;
+	const auto twiddle = [&](size_t k, size_t m) { return std::polar(1.0, -2.0 * M_PI * ((k * m) % num_samples) / num_samples); };
+	state_re.resize(size);
+	state_im.resize(size);
+	delta_re.resize(size);
+	delta_im.resize(size);
+	shifted.resize(hop_size);
+	// sample m of a group is rotated by step^m relative to the start of the group
+	step_re.resize(size);
+	step_im.resize(size);
+	for (size_t k = 0; k < size; ++k) {
+		step_re[k] = twiddle(k, 1).real();
+		step_im[k] = twiddle(k, 1).imag();
+	}
+	const size_t groups = (hop_size + phase_interval - 1) / phase_interval;
+	phase_re.resize(groups * size);
+	phase_im.resize(groups * size);
+	for (size_t group = 0; group < groups; ++group) {
+		for (size_t k = 0; k < size; ++k) {
+			const auto phase = twiddle(k, group * phase_interval);
+			phase_re[group * size + k] = phase.real();
+			phase_im[group * size + k] = phase.imag();
+		}
+	}
+	// shifting the buffer by a hop rotates every bin by its frequency
+	rotation_re.resize(size);
+	rotation_im.resize(size);
+	for (size_t k = 0; k < size; ++k) {
+		const auto rotation = std::conj(twiddle(k, hop_size));
+		rotation_re[k] = rotation.real();
+		rotation_im[k] = rotation.imag();
+	}
+}
+
+bool sliding_dft::supported(window_type window) {
+	float a0, a1;
+	return window::cosine_coefficients(window, a0, a1);
+}
+
+bool sliding_dft::continues(const float *data) const {
+	const auto hop = hop_size;
+	if (remembered.empty() || hop >= num_samples) {
+		return false;
+	}
+	// the new buffer must be the old one, shifted by exactly one hop
+	return std::memcmp(remembered.data() + hop, data, (num_samples - hop) * sizeof(float)) == 0;
+}
+
+void sliding_dft::remember(const float *data) {
+	remembered.assign(data, data + num_samples);
+}
+
+bool sliding_dft::slide(const float *data) {
+	/**
+	 * After this many buffers we compute the spectrum from scratch,
+	 * so that rounding errors can not accumulate indefinitely
+	 */
+	constexpr const size_t resync_interval = 256;
+	const auto n = num_samples;
+	const auto hop = hop_size;
+	if (leaving.empty() || hop >= n || frames_since_resync >= resync_interval) {
+		return false;
+	}
+
+	/**
+	 * The new buffer lacks the first hop samples of the old one and has hop new samples at the end,
+	 * these are exactly one period apart and therefore share their twiddle factors.
+	 * So X'_k = e^{2 pi i k hop / n} * (X_k + sum_m (x_{n + m} - x_m) * e^{-2 pi i k m / n})
+	 */
+	for (size_t m = 0; m < hop; ++m) {
+		shifted[m] = data[n - hop + m] - leaving[m];
+	}
+	const auto size = state_re.size();
+	std::fill(delta_re.begin(), delta_re.end(), 0.f);
+	std::fill(delta_im.begin(), delta_im.end(), 0.f);
+	for (size_t first = 0; first < hop; first += phase_interval) {
+		const auto phase = first / phase_interval * size;
+		simd::rotating_sums(shifted.data() + first, std::min(phase_interval, hop - first), phase_re.data() + phase, phase_im.data() + phase, step_re.data(), step_im.data(), delta_re.data(), delta_im.data(), size);
+	}
+	for (size_t k = 0; k < size; ++k) {
+		const auto re = state_re[k] + delta_re[k];
+		const auto im = state_im[k] + delta_im[k];
+		state_re[k] = rotation_re[k] * re - rotation_im[k] * im;
+		state_im[k] = rotation_re[k] * im + rotation_im[k] * re;
+	}
+
+	leaving.assign(data, data + hop);
+	++frames_since_resync;
+	return true;
+}
+
+void sliding_dft::reset(const float *data, const std::complex<float> *values) {
+	for (size_t k = 0; k < state_re.size(); ++k) {
+		state_re[k] = values[k].real();
+		state_im[k] = values[k].imag();
+	}
+	leaving.assign(data, data + hop_size);
+	frames_since_resync = 0;
+}
+
+void sliding_dft::spectrum(std::complex<float> *result) const {
+	/**
+	 * Multiplying with a0 - a1 * cos(2 pi i / n) in the time domain
+	 * is a convolution with the three taps -a1 / 2, a0, -a1 / 2 in the frequency domain.
+	 * The spectrum of real samples is symmetric, so the missing neighbours at both ends are complex conjugates.
+	 */
+	const float neighbour = a1 / 2.f;
+	const auto last = state_re.size() - 1;
+	for (size_t k = 0; k <= last; ++k) {
+		const auto lower = (k == 0) ? std::complex(state_re[1], -state_im[1]) : std::complex(state_re[k - 1], state_im[k - 1]);
+		const auto upper = (k == last) ? std::complex(state_re[last - 1], -state_im[last - 1]) : std::complex(state_re[k + 1], state_im[k + 1]);
+		result[k] = a0 * std::complex(state_re[k], state_im[k]) - neighbour * (lower + upper);
+	}
+}
+
+}
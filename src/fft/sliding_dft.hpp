@@ -0,0 +1,92 @@
+#pragma once
+
+#include <complex>
+#include <vector>
+
+#include "config.hpp"
+
+namespace fftune {
+
+/**
+ * @brief A sliding discrete fourier transformation
+ *
+ * This object keeps the spectrum of the last buffer. If the next buffer is the last one shifted by a hop,
+ * the spectrum is updated by only accounting for the samples that were shifted in and out.
+ *
+ * The windowing function is applied in the frequency domain,
+ * therefore only windows of the form supported by window::cosine_coefficients() can be used.
+ */
+class sliding_dft {
+public:
+	sliding_dft() = delete;
+	/**
+	 * @brief Constructs a sliding_dft object
+	 *
+	 * The buffers hold \p num_samples samples and consecutive buffers are shifted by \p hop_size samples.
+	 * The windowing function \p window is applied to every spectrum, it must be supported().
+	 */
+	sliding_dft(size_t num_samples, size_t hop_size, window_type window);
+	/**
+	 * @brief Checks if a windowing function can be used
+	 *
+	 * Returns \c true iff \p window can be applied in the frequency domain
+	 */
+	static bool supported(window_type window);
+	/**
+	 * @brief Checks if a buffer continues the remembered one
+	 *
+	 * Returns \c true iff the \a num_samples samples in \p data are the buffer passed to remember(), shifted by a hop
+	 */
+	bool continues(const float *data) const;
+	/**
+	 * @brief Remembers a buffer
+	 *
+	 * Keeps a copy of the \a num_samples samples in \p data, so that continues() can compare the next buffer to it.
+	 * This is only needed, if it is not known whether the next buffer continues this one.
+	 */
+	void remember(const float *data);
+	/**
+	 * @brief Slides the spectrum to a new buffer
+	 *
+	 * Updates the spectrum to the \a num_samples samples in \p data, which must be the last buffer shifted by a hop.
+	 * Returns \c false without changing anything, if the spectrum is due to be resynchronized,
+	 * in that case the spectrum has to be computed from scratch and passed to reset().
+	 */
+	bool slide(const float *data);
+	/**
+	 * @brief Restarts the spectrum
+	 *
+	 * Sets the spectrum of the samples \p data to \p values, which must hold the unwindowed spectrum, e.g. computed with a FFT
+	 */
+	void reset(const float *data, const std::complex<float> *values);
+	/**
+	 * @brief Returns the spectrum
+	 *
+	 * Writes the windowed spectrum of the last buffer to \p result, which must hold space for \f$\frac{n}{2} + 1\f$ values
+	 */
+	void spectrum(std::complex<float> *result) const;
+private:
+	size_t num_samples;
+	size_t hop_size;
+	float a0 = 1.f;
+	float a1 = 0.f;
+	size_t frames_since_resync = 0;
+	// the first hop samples of the last buffer, which are shifted out by the next one
+	std::vector<float> leaving;
+	std::vector<float> shifted;
+	std::vector<float> remembered;
+	// the unwindowed spectrum of the last buffer
+	std::vector<float> state_re;
+	std::vector<float> state_im;
+	std::vector<float> delta_re;
+	std::vector<float> delta_im;
+	// the phases of every bin at the start of every group of shifted samples
+	std::vector<float> phase_re;
+	std::vector<float> phase_im;
+	std::vector<float> step_re;
+	std::vector<float> step_im;
+	std::vector<float> rotation_re;
+	std::vector<float> rotation_im;
+};
+
+}
@@ -0,0 +1,68 @@
+#include "spectrum_buffer.hpp"
+
+#include <cmath>
+
+namespace fftune {
+
+spectrum_buffer::spectrum_buffer(size_t size) {
+	resize(size);
+}
+
+void spectrum_buffer::resize(size_t size) {
+	magnitudes.resize(size);
+	powers.resize(size);
+	frequencies.resize(size);
+	values.resize(size);
+}
+
+size_t spectrum_buffer::size() const {
+	return magnitudes.size();
+}
+
+bool spectrum_buffer::empty() const {
+	return magnitudes.empty();
+}
+
+bin spectrum_buffer::operator[](size_t index) const {
+	return bin(values[index].real(), values[index].imag(), magnitudes[index], frequencies[index]);
+}
+
+bins spectrum_buffer::to_bins() const {
+	bins result;
+	result.reserve(size());
+	for (size_t i = 0; i < size(); ++i) {
+		result.push_back((*this)[i]);
+	}
+	return result;
+}
+
+float spectrum_buffer::peak_offset(size_t index) const {
+	if (index == 0 || index + 1 >= size()) {
+		return 0.f;
+	}
+	const auto left = magnitudes[index - 1];
+	const auto center = magnitudes[index];
+	const auto right = magnitudes[index + 1];
+	// silent neighbours have no finite magnitude to fit, and a parabola that opens upwards has no maximum
+	const auto curvature = left - 2.f * center + right;
+	if (!std::isfinite(curvature) || curvature >= 0.f) {
+		return 0.f;
+	}
+	return 0.5f * (left - right) / curvature;
+}
+
+float spectrum_buffer::interpolated_frequency(size_t index) const {
+	return frequencies[index] + peak_offset(index) * frequencies[1];
+}
+
+float spectrum_buffer::phase_frequency(const spectrum_buffer &previous, size_t index, size_t hop_size) const {
+	constexpr const float pi2 = M_PI * 2.f;
+	const float num_samples = 2.f * (size() - 1);
+	// the phase advance of a sinusoid exactly at the bin frequency
+	const float expected = pi2 * index * hop_size / num_samples;
+	const float deviation = std::remainder(std::arg(values[index]) - std::arg(previous.values[index]) - expected, pi2);
+	// the bin resolution times the buffer size is the sample rate
+	return frequencies[index] + deviation * frequencies[1] * num_samples / (pi2 * hop_size);
+}
+
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "bin.hpp"
+
+namespace fftune {
+
+/**
+ * @brief Selects the quantities of a spectrum
+ *
+ * Computing all quantities of every bin can be wasteful, if only some of them are needed.
+ * The complex values are always available.
+ */
+struct spectrum_fields {
+	/**
+	 * @brief Whether to compute spectrum_buffer::magnitudes
+	 */
+	bool magnitudes = true;
+	/**
+	 * @brief Whether to compute spectrum_buffer::powers
+	 */
+	bool powers = false;
+	/**
+	 * @brief Whether to compute spectrum_buffer::frequencies
+	 */
+	bool frequencies = true;
+};
+
+/**
+ * @brief A buffer holding a frequency spectrum
+ *
+ * This holds the same information as bins, but stores every quantity in its own contiguous array,
+ * so that loops over e.g. only the magnitudes do not have to stride over data they do not use.
+ * It is meant to be allocated once and reused for every FFT.
+ */
+class spectrum_buffer {
+public:
+	spectrum_buffer() = default;
+	/**
+	 * @brief Constructs a spectrum_buffer
+	 *
+	 * The buffer will have space for \p size bins
+	 */
+	explicit spectrum_buffer(size_t size);
+	/**
+	 * @brief Resizes the buffer
+	 *
+	 * The buffer will have space for \p size bins afterwards
+	 */
+	void resize(size_t size);
+	/**
+	 * @brief Returns the number of bins
+	 *
+	 * This is the size of every array in this buffer
+	 */
+	size_t size() const;
+	/**
+	 * @brief Checks if the buffer is empty
+	 *
+	 * Returns \c true iff there are no bins
+	 */
+	bool empty() const;
+	/**
+	 * @brief Returns a bin
+	 *
+	 * Assembles the bin at \p index, like an element of bins
+	 */
+	bin operator[](size_t index) const;
+	/**
+	 * @brief Converts the buffer to bins
+	 *
+	 * This allocates a new bins object with the same content
+	 */
+	bins to_bins() const;
+	/**
+	 * @brief Returns the position of a peak between the bins
+	 *
+	 * Fits a parabola through the magnitudes of the bin at \p index and its neighbours and returns the offset of its vertex in bins.
+	 * Since the magnitudes are logarithmic, this is very accurate for the peaks of windowed sinusoids.
+	 * The offset lies within \f$[-0.5, 0.5]\f$ if the bin is a local maximum, for any other bin it is meaningless.
+	 */
+	float peak_offset(size_t index) const;
+	/**
+	 * @brief Returns the interpolated frequency of a peak
+	 *
+	 * This is the frequency of the bin at \p index, moved by peak_offset().
+	 * Requires #frequencies.
+	 */
+	float interpolated_frequency(size_t index) const;
+	/**
+	 * @brief Returns the frequency of a bin from its phase
+	 *
+	 * Estimates the frequency of the sinusoid in the bin at \p index like a phase vocoder,
+	 * from the phase advance since the spectrum \p previous of the buffer \p hop_size samples earlier.
+	 * The estimate is unambiguous for frequencies within \f$\frac{n}{2 \cdot hop\_size}\f$ bins of the bin, so buffers must overlap.
+	 * Requires #frequencies.
+	 */
+	float phase_frequency(const spectrum_buffer &previous, size_t index, size_t hop_size) const;
+	/**
+	 * @brief The magnitudes of all bins
+	 *
+	 * This holds the volume of every bin in decibel
+	 */
+	std::vector<float> magnitudes;
+	/**
+	 * @brief The linear powers of all bins
+	 *
+	 * This holds the squared normalized amplitude of every bin, i.e. \f$10^{m / 10}\f$ for a magnitude \f$m\f$
+	 */
+	std::vector<float> powers;
+	/**
+	 * @brief The frequencies of all bins
+	 *
+	 * This holds the frequency of every bin
+	 */
+	std::vector<float> frequencies;
+	/**
+	 * @brief The complex values of all bins
+	 *
+	 * This holds the raw FFT output of every bin
+	 */
+	std::vector<std::complex<float>> values;
+};
+
+}
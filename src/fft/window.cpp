@@ -1,5 +1,10 @@
 #include "window.hpp"
 
+#include <map>
+#include <mutex>
+
+#include "util/simd.hpp"
+
 namespace fftune {
 
 void window::default_window(sample_buffer &data) {
@@ -10,6 +15,61 @@ void window::default_window(float *data, size_t size) {
 	return window::templ_window<window::welch>(data, size);
 }
 
+window::window_f window::function(window_type type) {
+	switch (type) {
+	case window_type::Rectangular:
+		return rectangular;
+	case window_type::Hanning:
+		return hanning;
+	case window_type::Hamming:
+		return hamming;
+	case window_type::Welch:
+		return welch;
+	default:
+		return welch;
+	}
+}
+
+const std::vector<float> &window::table(window_type type, size_t size) {
+	static std::mutex cache_mutex;
+	// map nodes never move, so references to the tables stay valid
+	static std::map<std::pair<window_type, size_t>, std::vector<float>> cache;
+
+	std::lock_guard lock {cache_mutex};
+	auto [it, inserted] = cache.try_emplace({type, size});
+	if (inserted) {
+		const auto f = function(type);
+		it->second.resize(size);
+		for (size_t i = 0; i < size; ++i) {
+			it->second[i] = f(i, size);
+		}
+	}
+	return it->second;
+}
+
+void window::apply(const float *src, float *dest, const float *weights, size_t size) {
+	simd::multiply(weights, src, dest, size);
+}
+
+bool window::cosine_coefficients(window_type type, float &a0, float &a1) {
+	switch (type) {
+	case window_type::Rectangular:
+		a0 = 1.f;
+		a1 = 0.f;
+		return true;
+	case window_type::Hanning:
+		a0 = 0.5f;
+		a1 = 0.5f;
+		return true;
+	case window_type::Hamming:
+		a0 = 24.f / 46.f;
+		a1 = 1.f - a0;
+		return true;
+	default:
+		return false;
+	}
+}
+
 float window::rectangular(const size_t i, const size_t n) {
 	return 1.f;
 }
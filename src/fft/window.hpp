@@ -23,6 +23,33 @@ void templ_window(sample_buffer &data) {
 
 void default_window(sample_buffer &data);
 void default_window(float *data, size_t size);
+/**
+ * @brief Returns a windowing function
+ *
+ * Returns the function corresponding to \p type
+ */
+window_f function(window_type type);
+/**
+ * @brief Returns a precomputed window
+ *
+ * Returns the weights of the windowing function \p type for \p size samples.
+ * Every window is only computed once and then cached for the lifetime of the program, so the returned reference stays valid.
+ * This is thread-safe.
+ */
+const std::vector<float> &table(window_type type, size_t size);
+/**
+ * @brief Copies and windows data in one pass
+ *
+ * Writes \p size samples of \p src multiplied by \p weights to \p dest
+ */
+void apply(const float *src, float *dest, const float *weights, size_t size);
+/**
+ * @brief Returns the coefficients of a cosine window
+ *
+ * Writes \p a0 and \p a1 such that the window \p type is \f$a_0 - a_1 \cos(\frac{2 \pi i}{n})\f$.
+ * Returns \c false if \p type is not of that form.
+ */
+bool cosine_coefficients(window_type type, float &a0, float &a1);
 float rectangular(const size_t i, const size_t n);
 float hanning(const size_t i, const size_t n);
 float hamming(const size_t i, const size_t n);
@@ -56,12 +56,28 @@ bool audio_to_midi(audio_file &input_file, const std::filesystem::path &midi, co
 	// construct our pitch detection object
 	auto p = pitch_detector<T>(conf);
 
-	// read data in hops
-	while (input_file.read(buf, conf.hop_size)) {
-		auto notes = p.detect(buf);
-		output.add_notes(notes, duration);
-
-		verbose_log(notes, conf.verbose);
+	/**
+	 * Decode many hops at once, so that all buffers within them can be analyzed as a batch
+	 * The block holds the samples of all buffers of a batch, each buffer starts one hop after the previous one.
+	 * Reading into the block cycles it just like the single buffer, so the first buffer always starts at the start of the block.
+	 */
+	constexpr const size_t batch_hops = 64;
+	sample_buffer block {conf.buffer_size + (batch_hops - 1) * conf.hop_size};
+	block.read(buf.data, buf.size);
+	std::vector<note_estimates> batch;
+
+	// read data in batches of hops
+	while (const size_t num_read = input_file.read(block, batch_hops * conf.hop_size)) {
+		// a partial hop at the end of the file still makes up a buffer
+		const size_t num_frames = (num_read + conf.hop_size - 1) / conf.hop_size;
+		batch.clear();
+		p.detect(block.data, num_frames, conf.hop_size, batch);
+
+		for (const auto &notes : batch) {
+			output.add_notes(notes, duration);
+
+			verbose_log(notes, conf.verbose);
+		}
 	}
 
 	return output.write(midi);
@@ -59,6 +59,8 @@ int audio_file::read(sample_buffer &buf, size_t n) {
 	const auto channels = file.channels();
 	// first load into an intermediate buffer, this buffer holds all channels
 	const auto result = file.read(this->buffer->data, n * channels);
+	// everything past the end of the file is silent
+	std::fill(this->buffer->data + result, this->buffer->data + n * channels, 0.f);
 
 	// cycle the buffer if we don't overwrite the whole buffer (simulate a ringbuffer)
 	buf.cycle(n);
@@ -69,7 +71,7 @@ int audio_file::read(sample_buffer &buf, size_t n) {
 	}
 
 	if (result) {
-		return n;
+		return result / channels;
 	} else {
 		at_end = true;
 		return 0;
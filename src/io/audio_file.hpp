@@ -90,6 +90,7 @@ public:
 	 * @brief Reads \p n samples from the input file
 	 *
 	 * This will read \p n samples into \p buf
+	 * If the file ends before, the remaining samples are filled with silence.
 	 *
 	 * It will return the amount of samples read.
 	 */
@@ -0,0 +1,224 @@
+#include "difference_function.hpp"
+
+#include <cmath>
+#include <numeric>
+
+namespace fftune {
+
+difference_function::difference_function(const config &conf) {
+	this->conf = conf;
+	lag_begin = std::max(1.f, std::floor(freq_to_wavelength(conf.max_frequency(), conf.sample_rate)));
+	lag_end = std::min(conf.buffer_size, static_cast<size_t>(std::ceil(freq_to_wavelength(conf.min_frequency(), conf.sample_rate))) + 1);
+	if (conf.yin_difference == difference_method::Incremental) {
+		lags.resize(conf.buffer_size);
+		partial_sums.resize(conf.buffer_size);
+	}
+	if (conf.yin_difference == difference_method::Decimated) {
+		factor = conf.yin_decimation;
+		lags.resize(conf.buffer_size);
+		decimated.resize(conf.buffer_size / factor);
+		// one more coarse lag than needed, so that every lag of interest lies between two coarse lags, and room for the last block
+		coarse_lags.resize(std::min(decimated.size(), (lag_end - 1) / factor + 2) + simd::lag_block);
+	}
+#ifdef HAS_FFT
+	if (conf.yin_difference == difference_method::Fft) {
+		acf = std::make_unique<autocorrelation>(conf.buffer_size);
+		energy.resize(conf.buffer_size + 1);
+		lags.resize(conf.buffer_size);
+	}
+#endif
+}
+
+void difference_function::update(const sample_buffer &in) {
+	update(in.data);
+}
+
+void difference_function::update(const float *samples) {
+	data = samples;
+	block_begin = std::numeric_limits<size_t>::max();
+	if (conf.yin_difference == difference_method::Incremental) {
+		slide(samples);
+		return;
+	}
+	if (conf.yin_difference == difference_method::Decimated) {
+		decimate(samples);
+		return;
+	}
+#ifdef HAS_FFT
+	if (!acf) {
+		return;
+	}
+
+	/**
+	 * Expanding the square yields
+	 * d(tau) = sum_{j < n - tau} x_j^2 + sum_{tau <= j < n} x_j^2 - 2 * r(tau)
+	 * where r is the autocorrelation, so we only need prefix sums of the energy in addition
+	 */
+	const auto n = conf.buffer_size;
+	energy[0] = 0.0;
+	for (size_t j = 0; j < n; ++j) {
+		energy[j + 1] = energy[j] + squared(data[j]);
+	}
+	acf->detect(data, lags);
+	for (size_t tau = 0; tau < n; ++tau) {
+		const double d = energy[n - tau] + (energy[n] - energy[tau]) - 2.0 * lags[tau];
+		// rounding errors must not make the difference negative
+		lags[tau] = std::max(0.0, d);
+	}
+#endif
+}
+
+float difference_function::operator()(size_t tau) const {
+	if (!lags.empty()) {
+		return lags[tau];
+	}
+	if (tau < block_begin || tau - block_begin >= simd::lag_block) {
+		simd::squared_differences(data, conf.buffer_size, tau, block.data());
+		block_begin = tau;
+	}
+	return block[tau - block_begin];
+}
+
+size_t difference_function::min_lag() const {
+	return lag_begin;
+}
+
+size_t difference_function::max_lag() const {
+	return lag_end - 1;
+}
+
+bool difference_function::continues(const float *samples) const {
+	const auto hop = conf.hop_size;
+	if (previous.empty() || hop >= conf.buffer_size) {
+		return false;
+	}
+	// the new buffer must be the old one, shifted by exactly one hop
+	return std::memcmp(previous.data() + hop, samples, (conf.buffer_size - hop) * sizeof(float)) == 0;
+}
+
+void difference_function::slide(const float *samples) {
+	/**
+	 * After this many buffers we recompute everything from scratch,
+	 * so that rounding errors can not accumulate indefinitely
+	 */
+	constexpr const size_t resync_interval = 256;
+	const auto n = conf.buffer_size;
+	const auto hop = conf.hop_size;
+
+	if (continues(samples) && frames_since_resync < resync_interval) {
+		/**
+		 * Every lag is a sum over sample pairs (j, j + tau).
+		 * Shifting the buffer by one hop drops all pairs starting in the first hop samples of the previous buffer
+		 * and adds all pairs ending in the last hop samples of the new buffer, everything else stays the same.
+		 * Blocks of lags share the samples at the fixed end of their pairs, like simd::squared_differences.
+		 */
+		std::array<float, simd::lag_block> dropped, added;
+		size_t tau = 0;
+		for (; tau + simd::lag_block <= lag_end && tau + simd::lag_block - 1 + hop <= n; tau += simd::lag_block) {
+			simd::windowed_squared_differences(previous.data(), previous.data() + tau, hop, 1, dropped.data());
+			simd::windowed_squared_differences(samples + n - hop, samples + n - hop - tau, hop, -1, added.data());
+			for (size_t k = 0; k < simd::lag_block; ++k) {
+				partial_sums[tau + k] += static_cast<double>(added[k]) - dropped[k];
+			}
+		}
+		// lags longer than a buffer minus a hop drop and add fewer pairs
+		for (; tau < lag_end; ++tau) {
+			const auto count = std::min(hop, n - tau);
+			partial_sums[tau] += static_cast<double>(simd::squared_difference(samples + n - tau - count, samples + n - count, count)) - simd::squared_difference(previous.data(), previous.data() + tau, count);
+		}
+		++frames_since_resync;
+	} else {
+		std::array<float, simd::lag_block> sums;
+		for (size_t tau = 0; tau < lag_end; tau += simd::lag_block) {
+			simd::squared_differences(samples, n, tau, sums.data());
+			for (size_t k = 0; k < simd::lag_block && tau + k < lag_end; ++k) {
+				partial_sums[tau + k] = sums[k];
+			}
+		}
+		frames_since_resync = 0;
+	}
+
+	// lags beyond the searched range are never evaluated, so do not bother keeping them
+	for (size_t tau = 0; tau < lag_end; ++tau) {
+		// rounding errors must not make the difference negative
+		lags[tau] = std::max(0.0, partial_sums[tau]);
+	}
+	previous.assign(samples, samples + n);
+}
+
+void difference_function::decimate(const float *samples) {
+	/**
+	 * Coarse minima whose normalized difference is below this threshold are refined at full resolution.
+	 * This is much more tolerant than the thresholds of the Yin algorithms,
+	 * because the interpolated difference function does not dip as deep as the real one.
+	 */
+	constexpr const float refine_threshold = 0.5f;
+	/**
+	 * Periods of fewer decimated samples are too coarse to find their minima reliably,
+	 * so these short lags are always computed at full resolution, which is cheap compared to all other lags
+	 */
+	constexpr const size_t min_coarse_period = 8;
+	const auto m = decimated.size();
+
+	/**
+	 * Averaging every group of samples is a low-pass filter, which suppresses most of the content
+	 * that would otherwise be aliased by only keeping every factor-th sample
+	 */
+	for (size_t i = 0; i < m; ++i) {
+		decimated[i] = std::reduce(samples + i * factor, samples + (i + 1) * factor) / factor;
+	}
+	const auto exact_end = std::clamp<size_t>(min_coarse_period * factor, 1, lag_end);
+	// the coarse lag before the first interpolated lag is needed to tell if that one is a minimum
+	const auto coarse_begin = std::max<size_t>(exact_end / factor, 1) - 1;
+	const auto coarse_end = coarse_lags.size() - simd::lag_block;
+	for (size_t t = coarse_begin; t < coarse_end; t += simd::lag_block) {
+		simd::squared_differences(decimated.data(), m, t, coarse_lags.data() + t);
+	}
+
+	/**
+	 * Every coarse lag covers factor lags at full resolution, which also sum up factor times as many sample pairs.
+	 * The lags inbetween are interpolated linearly.
+	 * The lags below the note range are needed as well, because they still count towards the cumulative mean.
+	 */
+	refine(samples, 1, exact_end);
+	for (size_t tau = exact_end; tau < lag_end; ++tau) {
+		const auto t = std::min(tau / factor, coarse_end - 1);
+		const auto next = std::min(t + 1, coarse_end - 1);
+		const auto frac = static_cast<float>(tau - t * factor) / factor;
+		lags[tau] = factor * std::lerp(coarse_lags[t], coarse_lags[next], frac);
+	}
+
+	// find the coarse minima that look like a period, normalized like the Yin algorithms do
+	candidates.clear();
+	float cumulative_mean = 0.f;
+	for (size_t tau = 1; tau < lag_end; ++tau) {
+		cumulative_mean += lags[tau];
+		const auto t = tau / factor;
+		if (tau < std::max(exact_end, lag_begin) || tau % factor != 0 || t + 1 >= coarse_end) {
+			continue;
+		}
+		const bool minimum = coarse_lags[t] <= coarse_lags[t - 1] && coarse_lags[t] <= coarse_lags[t + 1];
+		if (minimum && lags[tau] / (cumulative_mean / static_cast<float>(tau)) < refine_threshold) {
+			candidates.push_back(t);
+		}
+	}
+
+	// the real minimum lies within one coarse lag of the coarse one
+	size_t refined_end = exact_end;
+	for (const auto t : candidates) {
+		const auto first = std::max(refined_end, (t - 1) * factor + 1);
+		const auto last = std::min(lag_end, (t + 1) * factor);
+		refine(samples, first, last);
+		refined_end = std::max(refined_end, last);
+	}
+}
+
+void difference_function::refine(const float *samples, size_t first, size_t last) {
+	std::array<float, simd::lag_block> sums;
+	for (size_t tau = first; tau < last; tau += simd::lag_block) {
+		simd::squared_differences(samples, conf.buffer_size, tau, sums.data());
+		std::copy_n(sums.begin(), std::min(simd::lag_block, last - tau), lags.begin() + tau);
+	}
+}
+
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <array>
+#include <limits>
+#include <memory>
+
+#include "fft/autocorrelation.hpp"
+#include "util/music.hpp"
+#include "util/simd.hpp"
+
+namespace fftune {
+
+/**
+ * @brief The Yin difference function
+ *
+ * This computes \f$d(\tau) = \sum_j (x_j - x_{j + \tau})^2\f$ for a buffer,
+ * which is the common core of the Yin based pitch detection algorithms.
+ * The way it is computed is determined by config::yin_difference.
+ */
+class difference_function {
+public:
+	/**
+	 * @brief Constructs a difference_function object
+	 *
+	 * The given config \p conf will be used
+	 */
+	explicit difference_function(const config &conf);
+	/**
+	 * @brief Loads a new buffer
+	 *
+	 * All following evaluations refer to the samples in \p in, which must stay alive until the next update.
+	 * Depending on the method, this may already compute all lags at once.
+	 */
+	void update(const sample_buffer &in);
+	/**
+	 * @brief Loads a new buffer
+	 *
+	 * Same as the above, but for the config::buffer_size samples starting at \p samples
+	 */
+	void update(const float *samples);
+	/**
+	 * @brief Evaluates the difference function
+	 *
+	 * Returns \f$d(\tau)\f$ for the lag \p tau of the last loaded buffer.
+	 * The direct computation evaluates simd::lag_block lags at once and answers the following lags from them,
+	 * so lags should be evaluated in ascending order.
+	 */
+	float operator()(size_t tau) const;
+	/**
+	 * @brief Returns the smallest lag of interest
+	 *
+	 * This is the period of config::max_frequency() in samples, but at least 1.
+	 * All lags from 1 to max_lag() can be evaluated, because the smaller lags are still needed to normalize the difference function.
+	 */
+	size_t min_lag() const;
+	/**
+	 * @brief Returns the largest lag of interest
+	 *
+	 * This is the period of config::min_frequency() in samples, but less than config::buffer_size
+	 */
+	size_t max_lag() const;
+private:
+	bool continues(const float *samples) const;
+	void slide(const float *samples);
+	void decimate(const float *samples);
+	void refine(const float *samples, size_t first, size_t last);
+	config conf;
+	size_t lag_begin;
+	size_t lag_end;
+	const float *data = nullptr;
+	std::vector<float> lags;
+	// the last block of lags of difference_method::Direct
+	mutable std::array<float, simd::lag_block> block;
+	mutable size_t block_begin = std::numeric_limits<size_t>::max();
+	// state of difference_method::Incremental
+	std::vector<float> previous;
+	std::vector<double> partial_sums;
+	size_t frames_since_resync = 0;
+	// state of difference_method::Decimated
+	size_t factor = 1;
+	std::vector<float> decimated;
+	std::vector<float> coarse_lags;
+	std::vector<size_t> candidates;
+#ifdef HAS_FFT
+	std::unique_ptr<autocorrelation> acf;
+	std::vector<double> energy;
+#endif
+};
+
+}
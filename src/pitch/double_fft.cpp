@@ -1,38 +1,76 @@
 #include "double_fft.hpp"
 
-#ifdef HAS_FFTW3F
+#ifdef HAS_FFT
 
 namespace fftune {
 
 double_fft::double_fft(const config &conf)
-	: spec(conf.buffer_size, conf.sample_rate) {
+	: spec(conf), cepstrum_fft(conf.buffer_size, conf.sample_rate, fft_heuristic::OptimizeRuntime, window_type::Rectangular), log_spectrum(conf.buffer_size) {
 	this->conf = conf;
 }
 
 note_estimates double_fft::detect(const sample_buffer &in) {
-	note_estimates result;
-	auto spectrum = spec.detect(in);
+	return detect(spec.detect_spectrum(in));
+}
+
+void double_fft::detect(const float *samples, size_t num_frames, size_t hop_size, std::vector<note_estimates> &result) {
+	spec.for_each_spectrum(samples, num_frames, hop_size, [&](size_t, const spectrum_buffer &spectrum, const spectrum_buffer *before) { result.push_back(detect(spectrum, before, hop_size)); });
+}
+
+note_estimates double_fft::detect(const spectrum_buffer &spectrum) {
+	return detect(spectrum, nullptr, 0);
+}
 
-	bins_normalize_sin(spectrum);
-	// stores the second fft
-	std::vector<std::pair<size_t, float>> dfft;
+note_estimates double_fft::detect(const spectrum_buffer &spectrum, const spectrum_buffer *previous, size_t hop_size) {
+	note_estimates result;
+	// silent bins would make the logarithm diverge
+	constexpr const float min_magnitude = -120.f;
+	const auto n = conf.buffer_size;
 
-	for (size_t step = 1; step < spectrum.size() / 2; ++step) {
-		// compute the mean
-		float sum = 0.f;
-		for (size_t i = 0; i < spectrum.size(); i += step) {
-			sum += spectrum[i].magnitude;
+	/**
+	 * The magnitudes are already logarithmic, and the spectrum of a real buffer is symmetric,
+	 * so mirroring them yields a full period of the logarithmic spectrum
+	 */
+	for (size_t k = 0; k < spectrum.size(); ++k) {
+		const auto magnitude = std::max(spectrum.magnitudes[k], min_magnitude);
+		log_spectrum.data[k] = magnitude;
+		if (k > 0 && k < n - k) {
+			log_spectrum.data[n - k] = magnitude;
 		}
+	}
+	// the second transformation yields the real cepstrum, whose peaks are the periods of the harmonic series
+	cepstrum_fft.detect(log_spectrum, cepstrum, {.magnitudes = false, .frequencies = false});
 
-		dfft.push_back(std::pair(step, sum));
+	// only periods of notes within the note range are of interest
+	const size_t begin = std::max(2.f, std::floor(freq_to_wavelength(conf.max_frequency(), conf.sample_rate)));
+	const size_t end = std::min(n / 2, static_cast<size_t>(std::ceil(freq_to_wavelength(conf.min_frequency(), conf.sample_rate))) + 1);
+	const auto quefrency = [&](size_t q) { return cepstrum.values[q].real(); };
+	candidates.clear();
+	for (size_t q = begin; q < end; ++q) {
+		if (quefrency(q) > 0.f && quefrency(q) > quefrency(q - 1) && quefrency(q) >= quefrency(q + 1)) {
+			candidates.push_back(std::pair(q, quefrency(q)));
+		}
 	}
-	// sort by mean
-	std::ranges::sort(dfft, [](const auto &l, const auto &r) { return l.second > r.second; });
+	std::ranges::sort(candidates, [](const auto &l, const auto &r) { return l.second > r.second; });
 
-	for (size_t i = 0; i < std::min(conf.max_polyphony, dfft.size()); ++i) {
-		const auto b = spectrum[dfft[i].first];
-		auto p = pitch_estimate(b.frequency, b.magnitude);
-		result.push_back(note_estimate(p));
+	// the spectral peaks tell the frequency much more accurately than the period, which is a whole number of samples
+	const auto [first, last] = spec.bins_range(conf);
+	find_peaks(spectrum, previous, hop_size, first, last, peaks);
+	for (size_t i = 0; i < std::min(conf.max_polyphony, candidates.size()); ++i) {
+		const auto q = candidates[i].first;
+		const auto left = quefrency(q - 1);
+		const auto center = quefrency(q);
+		const auto right = quefrency(q + 1);
+		const auto curvature = left - 2.f * center + right;
+		const float offset = curvature < 0.f ? 0.5f * (left - right) / curvature : 0.f;
+		auto frequency = wavelength_to_freq(q + offset, conf.sample_rate);
+		const auto nearest = std::ranges::min_element(peaks, {}, [&](const auto &p) { return std::abs(p.frequency - frequency); });
+		// a peak within half a semitone is the fundamental itself
+		if (nearest != peaks.end() && std::abs(std::log2(nearest->frequency / frequency)) < 0.5f / 12.f) {
+			frequency = nearest->frequency;
+		}
+		const auto index = std::min(spectrum.size() - 1, static_cast<size_t>(std::round(frequency / spectrum.frequencies[1])));
+		result.push_back(note_estimate(pitch_estimate(frequency, spectrum.magnitudes[index], candidates[i].second)));
 	}
 	return result;
 }
@@ -1,6 +1,6 @@
 #pragma once
 
-#ifdef HAS_FFTW3F
+#ifdef HAS_FFT
 
 #include "fft/fft.hpp"
 
@@ -9,7 +9,8 @@ namespace fftune {
 /**
  * @brief The double_fft pitch detection algorithm
  *
- * Performs pitch detection by applying something similar to a second FFT to the frequency spectrum
+ * Performs pitch detection by applying a second FFT to the logarithmic frequency spectrum.
+ * The result is the real cepstrum, whose peaks are the periods of the harmonic series in the buffer.
  */
 class double_fft {
 public:
@@ -25,9 +26,31 @@ public:
 	 * Performs pitch detection on the input buffer \p in
 	 */
 	note_estimates detect(const sample_buffer &in);
+	/**
+	 * @brief Performs pitch detection
+	 *
+	 * Performs pitch detection on a \p spectrum, that has the size and sample rate given in the config
+	 */
+	note_estimates detect(const spectrum_buffer &spectrum);
+	/**
+	 * @brief Performs pitch detection on multiple frames
+	 *
+	 * Performs pitch detection on \p num_frames frames, which start \p hop_size samples apart in \p samples,
+	 * and appends the notes of every frame to \p result. The spectra are computed in batches, see fft::for_each_spectrum()
+	 * If the frames overlap, the frequencies of the peaks are estimated from the phase advance between consecutive frames.
+	 */
+	void detect(const float *samples, size_t num_frames, size_t hop_size, std::vector<note_estimates> &result);
 private:
+	note_estimates detect(const spectrum_buffer &spectrum, const spectrum_buffer *previous, size_t hop_size);
 	config conf;
 	fft spec;
+	// transforms the logarithmic spectrum to the cepstrum
+	fft cepstrum_fft;
+	// scratch buffers reused for every buffer
+	sample_buffer log_spectrum;
+	spectrum_buffer cepstrum;
+	spectral_peaks peaks;
+	std::vector<std::pair<size_t, float>> candidates;
 };
 
 }
@@ -1,52 +1,156 @@
 #include "fast_comb.hpp"
 
-#ifdef HAS_FFTW3F
+#ifdef HAS_FFT
 
 namespace fftune {
 
+namespace {
+
+// how far the ratio of two frequencies may be off from an integer, so that they still count as harmonics of each other
+constexpr const float harmonic_tolerance = (SemitoneRatio - 1.f) / 0.25;
+
+/**
+ * Sorts the bin intervals and merges overlapping ones,
+ * so that every bin is only contained once
+ */
+void merge_intervals(std::vector<std::pair<size_t, size_t>> &intervals) {
+	std::ranges::sort(intervals);
+	size_t merged = 0;
+	for (const auto &interval : intervals) {
+		if (merged > 0 && interval.first <= intervals[merged - 1].second) {
+			intervals[merged - 1].second = std::max(intervals[merged - 1].second, interval.second);
+		} else {
+			intervals[merged++] = interval;
+		}
+	}
+	intervals.resize(merged);
+}
+
+}
+
 fast_comb::fast_comb(const config &conf)
-	: spec(conf.buffer_size, conf.sample_rate) {
+	: spec(conf) {
 	this->conf = conf;
+	peak_at.assign(spec.bins_size(), no_peak);
+
+	/**
+	 * Whether two peaks are harmonics of each other only depends on their bins, up to the interpolation within a bin.
+	 * So the bins, that can possibly hold an overtone or a subharmonic of a bin, are found once.
+	 * For every harmonic they form an interval, since the frequency of a peak lies within half a bin of its bin.
+	 */
+	std::tie(first_bin, last_bin) = spec.bins_range(conf);
+	first_bin = std::max<size_t>(first_bin, 1);
+	overtones.resize(last_bin - std::min(first_bin, last_bin));
+	subharmonics.resize(overtones.size());
+	// adds the bins strictly between begin and end, that lie within the note range
+	const auto add = [&](std::vector<std::pair<size_t, size_t>> &intervals, float begin, float end) {
+		const auto first = std::clamp<size_t>(std::max(0.f, std::floor(begin) + 1.f), first_bin, last_bin);
+		const auto last = std::clamp<size_t>(std::max(0.f, std::ceil(end)), first_bin, last_bin);
+		if (first < last) {
+			intervals.push_back(std::pair(first, last));
+		}
+	};
+	for (size_t bin = first_bin; bin < last_bin; ++bin) {
+		const float low = bin - 0.5f;
+		const float high = bin + 0.5f;
+		auto &bin_overtones = overtones[bin - first_bin];
+		for (float harmonic = 1.f; (harmonic - harmonic_tolerance) * low - 0.5f < last_bin; ++harmonic) {
+			add(bin_overtones, (harmonic - harmonic_tolerance) * low - 0.5f, (harmonic + harmonic_tolerance) * high + 0.5f);
+		}
+		merge_intervals(bin_overtones);
+		// only peaks at least about an octave below can replace a peak as its fundamental
+		auto &bin_subharmonics = subharmonics[bin - first_bin];
+		for (float harmonic = 2.f; high / (harmonic - harmonic_tolerance) + 0.5f > first_bin; ++harmonic) {
+			add(bin_subharmonics, low / (harmonic + harmonic_tolerance) - 0.5f, high / (harmonic - harmonic_tolerance) + 0.5f);
+		}
+		merge_intervals(bin_subharmonics);
+	}
 }
 
 note_estimates fast_comb::detect(const sample_buffer &in) {
+	return detect(spec.detect_spectrum(in));
+}
+
+void fast_comb::detect(const float *samples, size_t num_frames, size_t hop_size, std::vector<note_estimates> &result) {
+	spec.for_each_spectrum(samples, num_frames, hop_size, [&](size_t, const spectrum_buffer &spectrum, const spectrum_buffer *before) { result.push_back(detect(spectrum, before, hop_size)); });
+}
+
+note_estimates fast_comb::detect(const spectrum_buffer &spectrum) {
+	return detect(spectrum, nullptr, 0);
+}
+
+note_estimates fast_comb::detect(const spectrum_buffer &spectrum, const spectrum_buffer *previous, size_t hop_size) {
 	note_estimates result;
 	constexpr const float magnitude_factor = 1.1f;
 
-	auto spectrum = spec.detect(in);
-	// sort peaks by magnitude
-	std::ranges::sort(spectrum, [](const auto &l, const auto &r) { return l.magnitude > r.magnitude; });
+	// peaks outside of the note range can neither be picked nor influence the notes we pick
+	find_peaks(spectrum, previous, hop_size, first_bin, last_bin, peaks);
+	picked.assign(peaks.size(), false);
+	for (size_t i = 0; i < peaks.size(); ++i) {
+		peak_at[peaks[i].index] = i;
+	}
+	// the index of the remaining peak in a bin, if there is one
+	const auto remaining = [&](size_t bin) {
+		const auto i = peak_at[bin];
+		return (i != no_peak && !picked[i]) ? i : no_peak;
+	};
+
 	for (size_t voice = 0; voice < conf.max_polyphony; ++voice) {
-		size_t best = 0;
-		auto magnitude = magnitude_factor * spectrum[best].magnitude;
+		// start with the loudest remaining peak
+		size_t best = no_peak;
+		for (size_t i = 0; i < peaks.size(); ++i) {
+			if (!picked[i] && (best == no_peak || peaks[i].magnitude > peaks[best].magnitude)) {
+				best = i;
+			}
+		}
+		if (best == no_peak) {
+			break;
+		}
+		auto magnitude = magnitude_factor * peaks[best].magnitude;
 
-		// try to find a subharmonic that is loud enough to be the actual fundamental frequency
-		for (size_t subharmonic_candidate = 1; subharmonic_candidate < spectrum.size(); ++subharmonic_candidate) {
-			const auto candidate = spectrum[subharmonic_candidate];
-			if (candidate.magnitude > magnitude) {
+		// try to find a subharmonic that is loud enough to be the actual fundamental frequency, trying louder ones first
+		candidates.clear();
+		for (const auto &[begin, end] : subharmonics[peaks[best].index - first_bin]) {
+			for (size_t bin = begin; bin < end; ++bin) {
+				if (const auto i = remaining(bin); i != no_peak) {
+					candidates.push_back(i);
+				}
+			}
+		}
+		std::ranges::sort(candidates, [&](auto l, auto r) { return peaks[l].magnitude > peaks[r].magnitude; });
+		for (const auto candidate : candidates) {
+			if (peaks[candidate].magnitude > magnitude) {
 				// found one with high enough amplitude, but we still need to check if it is a subharmonic
-				const auto factor = spectrum[best].frequency / candidate.frequency;
+				const auto factor = peaks[best].frequency / peaks[candidate].frequency;
 				const auto drift_off = std::abs(factor - std::round(factor));
-				if ((drift_off < (SemitoneRatio - 1.f) / 0.25) && (factor > 1.5f)) {
+				if ((drift_off < harmonic_tolerance) && (factor > 1.5f)) {
 					// found one!
-					best = subharmonic_candidate;
-					magnitude = magnitude_factor * spectrum[best].magnitude;
+					best = candidate;
+					magnitude = magnitude_factor * peaks[best].magnitude;
 				}
 			}
 		}
-		result.push_back(note_estimate(pitch_estimate(spectrum[best])));
+		result.push_back(note_estimate(pitch_estimate(peaks[best].frequency, peaks[best].magnitude)));
 
 		// subtract the amplitude from overtones
-		for (size_t overtone_candidate = 0; overtone_candidate < spectrum.size(); ++overtone_candidate) {
-			const auto factor = spectrum[overtone_candidate].frequency / spectrum[best].frequency;
-			const auto drift_off = std::abs(factor - std::round(factor));
-			if (drift_off < (SemitoneRatio - 1.f) / 0.25) {
-				spectrum[overtone_candidate].magnitude -= std::abs(spectrum[best].magnitude);
+		const auto best_magnitude = std::abs(peaks[best].magnitude);
+		for (const auto &[begin, end] : overtones[peaks[best].index - first_bin]) {
+			for (size_t bin = begin; bin < end; ++bin) {
+				if (const auto i = remaining(bin); i != no_peak) {
+					const auto factor = peaks[i].frequency / peaks[best].frequency;
+					const auto drift_off = std::abs(factor - std::round(factor));
+					if (drift_off < harmonic_tolerance) {
+						peaks[i].magnitude -= best_magnitude;
+					}
+				}
 			}
 		}
-		// we don't need this one anymore, so erase it
-		spectrum.erase(spectrum.begin() + best);
-		std::ranges::sort(spectrum, [](const auto &l, const auto &r) { return l.magnitude > r.magnitude; });
+		// we don't need this one anymore
+		picked[best] = true;
+	}
+
+	for (const auto &peak : peaks) {
+		peak_at[peak.index] = no_peak;
 	}
 	return result;
 }
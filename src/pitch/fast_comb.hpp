@@ -1,6 +1,6 @@
 #pragma once
 
-#ifdef HAS_FFTW3F
+#ifdef HAS_FFT
 
 #include "fft/fft.hpp"
 
@@ -10,6 +10,7 @@ namespace fftune {
  * @brief The fast_comb pitch detection algorithm
  *
  * Performs pitch detection by sorting by the predominant peaks
+ * Only the local maxima of the spectrum are considered, see find_peaks()
  */
 class fast_comb {
 public:
@@ -25,9 +26,38 @@ public:
 	 * Performs pitch detection on the input buffer \p in
 	 */
 	note_estimates detect(const sample_buffer &in);
+	/**
+	 * @brief Performs pitch detection
+	 *
+	 * Performs pitch detection on a \p spectrum, that has the size and sample rate given in the config
+	 */
+	note_estimates detect(const spectrum_buffer &spectrum);
+	/**
+	 * @brief Performs pitch detection on multiple frames
+	 *
+	 * Performs pitch detection on \p num_frames frames, which start \p hop_size samples apart in \p samples,
+	 * and appends the notes of every frame to \p result. The spectra are computed in batches, see fft::for_each_spectrum()
+	 * If the frames overlap, the frequencies of the peaks are estimated from the phase advance between consecutive frames.
+	 */
+	void detect(const float *samples, size_t num_frames, size_t hop_size, std::vector<note_estimates> &result);
 private:
+	note_estimates detect(const spectrum_buffer &spectrum, const spectrum_buffer *previous, size_t hop_size);
 	config conf;
 	fft spec;
+	// the bins of the note range
+	size_t first_bin;
+	size_t last_bin;
+	// the intervals of bins, that can hold an overtone or a subharmonic of a peak, for every bin of the note range
+	std::vector<std::vector<std::pair<size_t, size_t>>> overtones;
+	std::vector<std::vector<std::pair<size_t, size_t>>> subharmonics;
+	// the peaks of the current spectrum
+	spectral_peaks peaks;
+	// the index of the peak in every bin and whether a peak has already been picked as a note
+	static constexpr const size_t no_peak = -1;
+	std::vector<size_t> peak_at;
+	std::vector<bool> picked;
+	// scratch buffer for the subharmonics of a peak
+	std::vector<size_t> candidates;
 };
 
 }
@@ -1,43 +1,107 @@
 #include "fftune_sfizz.hpp"
 
-#ifdef HAS_FFTW3F
+#ifdef HAS_FFT
 
 namespace fftune {
 
 fftune_sfizz::fftune_sfizz(const config &conf)
-	: guess_buffer(conf.buffer_size), spectrum(conf.buffer_size, conf.sample_rate) {
+	: spectrum(conf) {
 	this->conf = conf;
+	render_templates();
+}
+
+void fftune_sfizz::render_templates() {
 	// initialize sfizz backend
+	tone_generator tone_gen;
 	tone_gen.init(conf);
+	sample_buffer guess_buffer {conf.buffer_size};
+
+	const auto num_bins = spectrum.bins_size();
+	template_magnitudes.reserve(note_range() * num_bins);
+	template_powers.reserve(note_range() * num_bins);
+	spectrum_buffer note_spectrum;
+	for (int note = conf.min_note; note <= conf.max_note; ++note) {
+		// generate sound for this note only
+		tone_gen.start({note_estimate(note)});
+		tone_gen.gen(guess_buffer);
+		spectrum.detect(guess_buffer, note_spectrum, {.powers = true, .frequencies = false});
+
+		template_magnitudes.insert(template_magnitudes.end(), note_spectrum.magnitudes.begin(), note_spectrum.magnitudes.end());
+		template_powers.insert(template_powers.end(), note_spectrum.powers.begin(), note_spectrum.powers.end());
+	}
+	guess_spectra.resize(std::max<size_t>(conf.num_threads, 1), std::vector<float>(num_bins));
+	if (guess_spectra.size() > 1) {
+		workers = std::make_unique<worker_pool>(guess_spectra.size());
+	}
+}
+
+void fftune_sfizz::guess(const note_estimates &notes, std::span<float> result) const {
+	const auto num_bins = spectrum.bins_size();
+	if (notes.size() == 1) {
+		const auto magnitudes = template_magnitudes.begin() + (notes.front().note - conf.min_note) * num_bins;
+		std::copy(magnitudes, magnitudes + num_bins, result.begin());
+		return;
+	}
+
+	/**
+	 * Without knowing their phases, the best approximation for the spectrum of multiple notes
+	 * is the sum of their power spectra
+	 */
+	for (size_t i = 0; i < num_bins; ++i) {
+		float power = 0.f;
+		for (const auto &n : notes) {
+			power += template_powers[(n.note - conf.min_note) * num_bins + i];
+		}
+		result[i] = 10.f * std::log10(std::max(power, std::numeric_limits<float>::min()));
+	}
 }
 
 note_estimates fftune_sfizz::detect(const sample_buffer &in) {
-	note_estimates sounding_notes;
-	const float mean_rec_volume = mean_volume(in);
-	const auto rec_spectrum = spectrum.detect(in);
+	spectrum.detect(in, recording, {.frequencies = false});
+	return detect(recording.magnitudes, mean_volume(in));
+}
 
-	const int max_id = power(MidiRange, conf.max_polyphony);
-	std::pair<int, float> best_guess {MidiInvalid, std::numeric_limits<float>::max()};
-	float confidence = 0.f;
+void fftune_sfizz::detect(const float *samples, size_t num_frames, size_t hop_size, std::vector<note_estimates> &result) {
+	const auto visit = [&](size_t frame, const spectrum_buffer &rec, const spectrum_buffer *) { result.push_back(detect(rec.magnitudes, mean_volume(samples + frame * hop_size, conf.buffer_size))); };
+	spectrum.for_each_spectrum(samples, num_frames, hop_size, visit, {.frequencies = false});
+}
 
-	// iterate over all possible notes
-	for (int id = 0; id < max_id; ++id) {
+note_estimates fftune_sfizz::detect(std::span<const float> rec_magnitudes, float mean_rec_volume) {
+	auto [sounding_notes, confidence] = (conf.search_width == 0) ? search_exhaustive(rec_magnitudes) : search_pruned(rec_magnitudes);
+
+	// check if we are confident enough
+	constexpr const float confidence_threshold = 0.00f;
+	if (confidence > confidence_threshold) {
+		for (auto &n : sounding_notes) {
+			n.velocity = volume_to_velocity(mean_rec_volume);
+			n.confidence = confidence;
+		}
+	} else {
 		sounding_notes.clear();
-		// gather all currently pending notes
-		this->add_notes(sounding_notes, id);
-		// generate sound from our notes
-		tone_gen.start(sounding_notes);
-		tone_gen.gen(guess_buffer);
+	}
 
-		/**
-		 * Match the volume of the generated sound with the volume of the input waveform
-		 * This is to avoid differences in volume having an effect on further steps of the algorithm
-		 */
-		match_volume(guess_buffer, mean_rec_volume);
-		const auto guess_spectrum = spectrum.detect(guess_buffer);
+	return sounding_notes;
+}
+
+std::pair<note_estimates, float> fftune_sfizz::search_exhaustive(std::span<const float> rec_magnitudes) {
+	const int max_id = power(note_range(), conf.max_polyphony);
+	scores.resize(max_id);
+	if (!workers) {
+		score_candidates(rec_magnitudes, 0, max_id, 1, guess_spectra.front());
+	} else {
+		// every worker scores its own share of the candidates, the calling thread does the first one
+		workers->run([&](size_t worker) { score_candidates(rec_magnitudes, worker, max_id, workers->size(), guess_spectra[worker]); });
+	}
+
+	std::pair<int, float> best_guess {MidiInvalid, std::numeric_limits<float>::max()};
+	float confidence = 0.f;
 
-		// evaluate similarity with a spectral difference function
-		const auto score = bins_distance_complete(rec_spectrum, guess_spectrum);
+	// pick the best candidate in order, so the result does not depend on the number of threads
+	for (int id = 0; id < max_id; ++id) {
+		if (!canonical(id)) {
+			continue;
+		}
+		const auto score = scores[id];
 		// did we find a better candidate?
 		if (score < best_guess.second) {
 			confidence = score_confidence(best_guess.second, score);
@@ -58,23 +122,108 @@ note_estimates fftune_sfizz::detect(const sample_buffer &in) {
 		}
 	}
 
-	sounding_notes.clear();
-	// check if we are confident enough
-	constexpr const float confidence_threshold = 0.00f;
-	if (confidence > confidence_threshold) {
+	note_estimates sounding_notes;
+	if (best_guess.first != MidiInvalid) {
 		// reload the best guess
 		this->add_notes(sounding_notes, best_guess.first);
+	}
+	return {sounding_notes, confidence};
+}
 
-		for (auto &n : sounding_notes) {
-			n.velocity = volume_to_velocity(mean_rec_volume);
-			n.confidence = confidence;
+std::pair<note_estimates, float> fftune_sfizz::search_pruned(std::span<const float> rec_magnitudes) {
+	using candidate = std::pair<note_estimates, float>;
+	const auto by_score = [](const auto &l, const auto &r) { return l.second < r.second; };
+	auto &guess_magnitudes = guess_spectra.front();
+	float best_score = std::numeric_limits<float>::max();
+	float runner_up_score = std::numeric_limits<float>::max();
+	note_estimates best_notes;
+
+	const auto evaluate = [&](const note_estimates &notes) {
+		guess(notes, guess_magnitudes);
+		const auto score = bins_distance_complete(rec_magnitudes, guess_magnitudes);
+		if (score < best_score) {
+			runner_up_score = best_score;
+			best_score = score;
+			best_notes = notes;
+		} else {
+			runner_up_score = std::min(runner_up_score, score);
+		}
+		return score;
+	};
+
+	// first score every single note and only keep the most promising ones
+	std::vector<candidate> beam;
+	for (int note = conf.min_note; note <= conf.max_note; ++note) {
+		const note_estimates notes = {note_estimate(note)};
+		beam.push_back({notes, evaluate(notes)});
+	}
+	const auto width = std::min(conf.search_width, beam.size());
+	std::ranges::partial_sort(beam, beam.begin() + width, by_score);
+	beam.resize(width);
+	// the notes that further voices are chosen from, sorted by pitch
+	std::vector<int> promising;
+	std::ranges::transform(beam, std::back_inserter(promising), [](const auto &c) { return c.first.front().note; });
+	std::ranges::sort(promising);
+
+	// then add one voice after another, but only to the best combinations of the previous size
+	for (size_t voices = 2; voices <= conf.max_polyphony && !beam.empty(); ++voices) {
+		std::vector<candidate> next;
+		for (const auto &[notes, score] : beam) {
+			// notes are always added in ascending order, so every combination is visited at most once
+			for (auto note = std::ranges::upper_bound(promising, notes.back().note); note != promising.end(); ++note) {
+				auto extended = notes;
+				extended.push_back(note_estimate(*note));
+				const auto extended_score = evaluate(extended);
+				// bound: a further voice has to explain the input better than the combination without it
+				if (extended_score < score) {
+					next.push_back({extended, extended_score});
+				}
+			}
 		}
+		const auto next_width = std::min(conf.search_width, next.size());
+		std::ranges::partial_sort(next, next.begin() + next_width, by_score);
+		next.resize(next_width);
+		beam = std::move(next);
 	}
 
-	return sounding_notes;
+	float confidence = score_confidence(runner_up_score, best_score);
+	if (best_score <= 0) {
+		// optimal and perfect match
+		confidence = 1.f;
+	}
+	return {best_notes, confidence};
+}
+
+void fftune_sfizz::score_candidates(std::span<const float> rec_magnitudes, size_t first_block, int max_id, size_t stride, std::span<float> guess_magnitudes) {
+	/**
+	 * The candidates are split into blocks, which are dealt out to the workers in turns.
+	 * Blocks keep the workers from writing to the same cache lines of the scores
+	 * and dealing them out in turns balances the work, because the canonical ids are not evenly distributed.
+	 */
+	constexpr const int block_size = 256;
+	note_estimates sounding_notes;
+	for (int block = first_block * block_size; block < max_id; block += stride * block_size) {
+		for (int id = block; id < std::min(block + block_size, max_id); ++id) {
+			if (!canonical(id)) {
+				continue;
+			}
+			sounding_notes.clear();
+			// gather all currently pending notes
+			add_notes(sounding_notes, id);
+			/**
+			 * Assemble the spectrum of our notes from the cached templates
+			 * There is no need to match the volume with the input waveform,
+			 * because a different volume only shifts all magnitudes by the same amount, which the distance function normalizes away
+			 */
+			guess(sounding_notes, guess_magnitudes);
+
+			// evaluate similarity with a spectral difference function
+			scores[id] = bins_distance_complete(rec_magnitudes, guess_magnitudes);
+		}
+	}
 }
 
-void fftune_sfizz::add_notes(note_estimates &notes, int id) {
+void fftune_sfizz::add_notes(note_estimates &notes, int id) const {
 	// iterate over all voices
 	for (size_t voice = 0; voice < conf.max_polyphony; ++voice) {
 		/**
@@ -85,17 +234,39 @@ void fftune_sfizz::add_notes(note_estimates &notes, int id) {
 		 * Instead we can iterate with a single for loop over all voices simultaneously,
 		 * because we encode all voices in a single variable.
 		 */
-		const int note = MidiMin + id % MidiRange;
+		const int note = conf.min_note + id % note_range();
 
 		// do not add the same note twice in a polyphonic setting
 		if (!std::ranges::any_of(notes, [&](const auto &e) { return e.note == note; })) {
 			notes.push_back(note_estimate(note));
 		}
 
-		id /= MidiRange;
+		id /= note_range();
 	}
 }
 
+bool fftune_sfizz::canonical(int id) const {
+	/**
+	 * Permuting the voices of an id yields the same set of notes and therefore the same score,
+	 * so only the permutation with non-decreasing notes is evaluated.
+	 * Otherwise the confidence would collapse when comparing a guess to its own permutations.
+	 */
+	int last_note = 0;
+	for (size_t voice = 0; voice < conf.max_polyphony; ++voice) {
+		const int note = id % note_range();
+		if (note < last_note) {
+			return false;
+		}
+		last_note = note;
+		id /= note_range();
+	}
+	return true;
+}
+
+int fftune_sfizz::note_range() const {
+	return conf.max_note + 1 - conf.min_note;
+}
+
 float fftune_sfizz::score_confidence(const float a, const float b) {
 	/**
 	 * the further apart the scores are, the higher the confidence
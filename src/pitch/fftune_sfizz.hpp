@@ -1,9 +1,12 @@
 #pragma once
 
-#ifdef HAS_FFTW3F
+#ifdef HAS_FFT
+
+#include <memory>
 
 #include "fft/fft.hpp"
 #include "tone_generator.hpp"
+#include "util/worker_pool.hpp"
 
 namespace fftune {
 
@@ -12,6 +15,11 @@ namespace fftune {
  *
  * This algorithm uses the sfizz library to create audio and compares the input sound and the created sound in the frequency spectrum to determine how close they are.
  * It then picks the closest note with regard to that distance function.
+ *
+ * The spectrum of every single note is rendered only once at construction,
+ * polyphonic guesses are then assembled by adding up the power spectra of their notes.
+ * The candidates can be scored on multiple threads, see config::num_threads,
+ * and the search can be pruned to the most promising notes, see config::search_width.
  */
 class fftune_sfizz {
 public:
@@ -27,13 +35,39 @@ public:
 	 * This performs pitch detection on the input buffer \p in
 	 */
 	note_estimates detect(const sample_buffer &in);
+	/**
+	 * @brief Performs pitch detection on multiple frames
+	 *
+	 * Performs pitch detection on \p num_frames frames, which start \p hop_size samples apart in \p samples,
+	 * and appends the notes of every frame to \p result. The spectra are computed in batches, see fft::for_each_spectrum()
+	 */
+	void detect(const float *samples, size_t num_frames, size_t hop_size, std::vector<note_estimates> &result);
 private:
-	void add_notes(note_estimates &notes, int id);
+	note_estimates detect(std::span<const float> rec_magnitudes, float mean_rec_volume);
+	std::pair<note_estimates, float> search_exhaustive(std::span<const float> rec_magnitudes);
+	std::pair<note_estimates, float> search_pruned(std::span<const float> rec_magnitudes);
+	void score_candidates(std::span<const float> rec_magnitudes, size_t first_block, int max_id, size_t stride, std::span<float> guess_magnitudes);
+	void add_notes(note_estimates &notes, int id) const;
+	bool canonical(int id) const;
+	int note_range() const;
+	void render_templates();
+	void guess(const note_estimates &notes, std::span<float> result) const;
 	float score_confidence(const float a, const float b);
 	config conf;
-	tone_generator tone_gen;
-	sample_buffer guess_buffer;
 	fft spectrum;
+	// the spectrum of the recording, reused for every buffer
+	spectrum_buffer recording;
+	/**
+	 * The cached spectra of all single notes, each template holds fft::bins_size() values
+	 * Stored both in decibel and as linear power, indexed by the Midi number relative to config::min_note
+	 */
+	std::vector<float> template_magnitudes;
+	std::vector<float> template_powers;
+	// the magnitudes of one scratch spectrum per worker thread
+	std::vector<std::vector<float>> guess_spectra;
+	std::vector<float> scores;
+	// the threads scoring the candidates, only started with multiple threads
+	std::unique_ptr<worker_pool> workers;
 };
 
 }
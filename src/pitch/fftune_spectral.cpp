@@ -1,55 +1,109 @@
 #include "fftune_spectral.hpp"
 
-#ifdef HAS_FFTW3F
+#ifdef HAS_FFT
 
 namespace fftune {
 
 fftune_spectral::fftune_spectral(const config &conf)
-	: spec(conf.buffer_size, conf.sample_rate) {
+	: spec(conf) {
 	this->conf = conf;
+	peak_at.assign(spec.bins_size(), no_peak);
 }
 
 note_estimates fftune_spectral::detect(const sample_buffer &in) {
+	return detect(spec.detect_spectrum(in));
+}
+
+void fftune_spectral::detect(const float *samples, size_t num_frames, size_t hop_size, std::vector<note_estimates> &result) {
+	spec.for_each_spectrum(samples, num_frames, hop_size, [&](size_t, const spectrum_buffer &spectrum, const spectrum_buffer *before) { result.push_back(detect(spectrum, before, hop_size)); });
+}
+
+note_estimates fftune_spectral::detect(const spectrum_buffer &spectrum) {
+	return detect(spectrum, nullptr, 0);
+}
+
+note_estimates fftune_spectral::detect(const spectrum_buffer &spectrum, const spectrum_buffer *previous, size_t hop_size) {
 	note_estimates result;
-	constexpr const int local_width = 5;
-	pitch_estimates candidates;
-
-	const auto spectrum = spec.detect(in);
-	for (int i = 0; i < spectrum.size(); ++i) {
-		const auto &candidate = spectrum[i];
-
-		// compute local mean
-		float local_mean = 0.f;
-		size_t num_locals = 0;
-		for (int j = std::max(i - local_width, 0); j < std::min(i + local_width, static_cast<int>(spectrum.size())); ++j) {
-			local_mean += spectrum[j].magnitude;
-			++num_locals;
+	constexpr const size_t local_width = 5;
+	// overtones above this harmonic of the highest note are not considered
+	constexpr const float max_harmonic = 16.f;
+	// the number of partials, whose weight is summed up for every candidate
+	constexpr const size_t num_partials = 16;
+	// how far the ratio of a partial to its candidate may be off from the harmonic
+	constexpr const float tolerance = SemitoneRatio - 1.f;
+	// peaks this far below the loudest one are considered noise
+	constexpr const float dynamic_range = 80.f;
+
+	const auto &magnitudes = spectrum.magnitudes;
+	/**
+	 * Peaks below the note range could only ever contribute to even lower candidates,
+	 * peaks above it can not become candidates themselves, but still contribute their weight as overtones
+	 */
+	const auto [first, last] = spec.bins_range(conf);
+	const size_t end = std::min(spectrum.size(), static_cast<size_t>(std::ceil(max_harmonic * last)));
+	find_peaks(spectrum, previous, hop_size, first, end, peaks);
+	if (peaks.empty()) {
+		return result;
+	}
+	// the mean magnitude of the neighbourhood of every bin
+	local_means.resize(spectrum.size());
+	sliding_mean(magnitudes, local_width, local_width, local_means);
+
+	// only peaks standing out of their neighbourhood count, every candidate starts with its own weight
+	const auto loudest = std::ranges::max(peaks, {}, &spectral_peak::magnitude).magnitude;
+	weights.resize(peaks.size());
+	scores.resize(peaks.size());
+	for (size_t i = 0; i < peaks.size(); ++i) {
+		weights[i] = peaks[i].magnitude < loudest - dynamic_range ? 0.f : peaks[i].magnitude - local_means[peaks[i].index];
+		scores[i] = weights[i];
+		if (weights[i] > 0.f && peaks[i].index < last) {
+			peak_at[peaks[i].index] = i;
+		}
+	}
+
+	/**
+	 * Every peak adds its weight to the candidates it is a partial of.
+	 * A candidate is looked up directly at the bins around the subharmonic frequency of the peak,
+	 * the closer the peak is to the exact harmonic, the more weight it adds.
+	 */
+	const float resolution = spectrum.frequencies[1];
+	for (size_t i = 0; i < peaks.size(); ++i) {
+		if (weights[i] <= 0.f) {
+			continue;
 		}
-		local_mean /= num_locals;
-
-		const auto deviation = candidate.magnitude - local_mean;
-		const auto weight = deviation;
-
-		if (weight > 0) {
-			for (auto &c : candidates) {
-				const auto factor = candidate.frequency / c.frequency;
-				const auto drift_off = std::abs(factor - std::round(factor));
-				if (drift_off < (SemitoneRatio - 1.f)) {
-					// add our weight to the base pitch
-					c.confidence += weight * drift_off / (SemitoneRatio - 1.f);
-					;
-					if (factor < 1.5f) {
-						// TODO: maybe interpolate frequencies to improve accuracy
+		for (size_t harmonic = 2; harmonic <= num_partials; ++harmonic) {
+			const auto bin = static_cast<size_t>(std::lround(peaks[i].frequency / (harmonic * resolution)));
+			if (bin + 1 < first) {
+				break;
+			}
+			size_t candidate = no_peak;
+			float drift_off = tolerance;
+			for (size_t neighbour = std::max<size_t>(bin, 1) - 1; neighbour <= std::min(bin + 1, last - 1); ++neighbour) {
+				if (const auto c = peak_at[neighbour]; c != no_peak) {
+					const auto drift = std::abs(peaks[i].frequency / peaks[c].frequency - harmonic);
+					if (drift < drift_off) {
+						candidate = c;
+						drift_off = drift;
 					}
 				}
 			}
+			if (candidate != no_peak) {
+				scores[candidate] += weights[i] * (1.f - drift_off / tolerance);
+			}
+		}
+	}
 
-			candidates.push_back(pitch_estimate(candidate.frequency, candidate.magnitude, weight));
+	candidates.clear();
+	for (size_t i = 0; i < peaks.size(); ++i) {
+		if (peak_at[peaks[i].index] == i) {
+			candidates.push_back(pitch_estimate(peaks[i].frequency, peaks[i].magnitude, scores[i]));
 		}
+		peak_at[peaks[i].index] = no_peak;
 	}
 
-	std::ranges::sort(candidates, [](const auto &l, const auto &r) { return l.confidence > r.confidence; });
-	for (size_t i = 0; i < std::min(conf.max_polyphony, candidates.size()); ++i) {
+	const auto count = std::min(conf.max_polyphony, candidates.size());
+	std::ranges::partial_sort(candidates, candidates.begin() + count, [](const auto &l, const auto &r) { return l.confidence > r.confidence; });
+	for (size_t i = 0; i < count; ++i) {
 		result.push_back(note_estimate(candidates[i]));
 	}
 	return result;
@@ -1,6 +1,6 @@
 #pragma once
 
-#ifdef HAS_FFTW3F
+#ifdef HAS_FFT
 
 #include "fft/fft.hpp"
 
@@ -25,9 +25,33 @@ public:
 	 * Performs pitch detection on the input buffer \p in
 	 */
 	note_estimates detect(const sample_buffer &in);
+	/**
+	 * @brief Performs pitch detection
+	 *
+	 * Performs pitch detection on a \p spectrum, that has the size and sample rate given in the config
+	 */
+	note_estimates detect(const spectrum_buffer &spectrum);
+	/**
+	 * @brief Performs pitch detection on multiple frames
+	 *
+	 * Performs pitch detection on \p num_frames frames, which start \p hop_size samples apart in \p samples,
+	 * and appends the notes of every frame to \p result. The spectra are computed in batches, see fft::for_each_spectrum()
+	 * If the frames overlap, the frequencies of the peaks are estimated from the phase advance between consecutive frames.
+	 */
+	void detect(const float *samples, size_t num_frames, size_t hop_size, std::vector<note_estimates> &result);
 private:
+	note_estimates detect(const spectrum_buffer &spectrum, const spectrum_buffer *previous, size_t hop_size);
 	config conf;
 	fft spec;
+	// scratch buffers reused for every buffer
+	spectral_peaks peaks;
+	std::vector<float> local_means;
+	std::vector<float> weights;
+	std::vector<float> scores;
+	pitch_estimates candidates;
+	// the index of the candidate peak in every bin
+	static constexpr const size_t no_peak = -1;
+	std::vector<size_t> peak_at;
 };
 
 }
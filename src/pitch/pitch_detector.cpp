@@ -1,4 +1,23 @@
 #include "pitch_detector.hpp"
 
 namespace fftune {
+
+const config &load_wisdom([[maybe_unused]] const config &conf) {
+#ifdef HAS_FFTW3F
+	if (conf.wisdom_path) {
+		fft_import_wisdom(*conf.wisdom_path);
+	}
+#endif
+	return conf;
+}
+
+void save_wisdom([[maybe_unused]] const config &conf) {
+#ifdef HAS_FFTW3F
+	// without new plans the wisdom can not have changed, so the file is left alone
+	if (conf.wisdom_path && plan_cache::take_new_plans()) {
+		fft_export_wisdom(*conf.wisdom_path);
+	}
+#endif
+}
+
 }
@@ -10,6 +10,22 @@
 
 namespace fftune {
 
+/**
+ * @brief Loads the fftw wisdom of a config
+ *
+ * Imports the wisdom file config::wisdom_path of \p conf, if it is set, and returns \p conf.
+ * Does nothing if the library is built without fftw.
+ */
+const config &load_wisdom(const config &conf);
+/**
+ * @brief Saves the fftw wisdom of a config
+ *
+ * Exports all measured FFT plans to config::wisdom_path of \p conf, if it is set and new plans have been created since the last export.
+ * So the file is only written by pitch detectors that plan FFTs of sizes, which have not been planned before in this process.
+ * Does nothing if the library is built without fftw.
+ */
+void save_wisdom(const config &conf);
+
 /**
  * @brief A generic pitch detector
  *
@@ -29,16 +45,19 @@ public:
 	 * The \p conf parameter is another config than the templated config.
 	 * The templated config decides which pitch detection backend is used, at compile time.
 	 * The parameter config \p conf is passed to the underlying pitch detection backend at runtime.
+	 *
+	 * If \p conf has a wisdom path, the backend plans its FFTs with that wisdom, which is then updated if the backend planned new FFTs.
 	 */
 	explicit pitch_detector(config conf)
-		: method(conf) {
+		: method(load_wisdom(conf)), frame(conf.buffer_size) {
+		save_wisdom(conf);
 	}
 	/**
 	 * @brief The pitch detection backend
 	 *
 	 * This member holds the correct pitch detection backend, and must be chosen at compile time.
 	 */
-#ifdef HAS_FFTW3F
+#ifdef HAS_FFT
 	typename std::conditional<T.algorithm == pitch_detection_method::Yin, yin, typename std::conditional<T.algorithm == pitch_detection_method::Fftune_Sfizz, fftune_sfizz, typename std::conditional<T.algorithm == pitch_detection_method::Fftune_Spectral, fftune_spectral, typename std::conditional<T.algorithm == pitch_detection_method::Fast_Comb, fast_comb, typename std::conditional<T.algorithm == pitch_detection_method::Double_Fft, double_fft, typename std::conditional<T.algorithm == pitch_detection_method::Yin_Patient, yin_patient, schmitt_trigger>::type>::type>::type>::type>::type>::type method {T};
 #else
 	typename std::conditional<T.algorithm == pitch_detection_method::Yin, yin, typename std::conditional<T.algorithm == pitch_detection_method::Yin_Patient, yin_patient, schmitt_trigger>::type>::type method {T};
@@ -51,6 +70,26 @@ public:
 	note_estimates detect(const sample_buffer &in) {
 		return method.detect(in);
 	}
+	/**
+	 * @brief Performs pitch detection on multiple frames
+	 *
+	 * This performs pitch detection on \p num_frames frames of config::buffer_size samples, which start \p hop_size samples apart in \p samples,
+	 * and appends the notes of every frame to \p result.
+	 * Backends based on the FFT transform the frames in batches, all others detect one frame after another.
+	 */
+	void detect(const float *samples, size_t num_frames, size_t hop_size, std::vector<note_estimates> &result) {
+		if constexpr (requires { method.detect(samples, num_frames, hop_size, result); }) {
+			method.detect(samples, num_frames, hop_size, result);
+		} else {
+			for (size_t i = 0; i < num_frames; ++i) {
+				frame.read(samples + i * hop_size, frame.size);
+				result.push_back(detect(frame));
+			}
+		}
+	}
+private:
+	// holds a single frame for backends without batch support
+	sample_buffer frame;
 };
 
 }
@@ -1,4 +1,5 @@
 #include "schmitt_trigger.hpp"
+#include "util/simd.hpp"
 
 namespace fftune {
 
@@ -15,11 +16,14 @@ note_estimates schmitt_trigger::detect(const sample_buffer &in) {
 	constexpr float step_away = 1.f - schmitt_threshold;
 	note_estimates result;
 	// find out boundaries of sample amplitudes
-	const auto buf_view = std::span(in.data, in.size);
-	const auto [min, max] = std::ranges::minmax_element(buf_view);
-	const auto diff = *max - *min;
-	const auto thresh_low = *min + step_away * diff;
-	const auto thresh_high = *max - step_away * diff;
+	if (in.size == 0) {
+		return result;
+	}
+	float min, max;
+	simd::minmax(in.data, in.size, min, max);
+	const auto diff = max - min;
+	const auto thresh_low = min + step_away * diff;
+	const auto thresh_high = max - step_away * diff;
 
 	size_t i = 0;
 
@@ -56,7 +60,7 @@ note_estimates schmitt_trigger::detect(const sample_buffer &in) {
 	const float periods = trigger_count / 2.f;
 	const float freq = conf.sample_rate / (conf.buffer_size / periods);
 	const auto candidate = pitch_estimate(freq);
-	if (candidate.valid()) {
+	if (conf.note_in_range(freq_to_midi(freq))) {
 		result.push_back(note_estimate(candidate));
 	}
 	return result;
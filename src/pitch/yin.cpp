@@ -2,22 +2,26 @@
 
 namespace fftune {
 
-yin::yin(const config &conf) {
+yin::yin(const config &conf)
+	: difference(conf) {
 	this->conf = conf;
 }
 
 note_estimates yin::detect(const sample_buffer &in) {
 	note_estimates result;
 	constexpr const float threshold = 0.1f;
+	difference.update(in);
 	// We don't need to recompute the mean every iteration
 	float cumulative_mean = 0.f;
-	for (size_t tau = 1; tau < conf.buffer_size; ++tau) {
-		float sum = 0.f;
-		for (size_t j = 0; j < conf.buffer_size - tau; ++j) {
-			sum += squared(in.data[j] - in.data[j + tau]);
-		}
+	/**
+	 * Lags above the note range are skipped entirely.
+	 * Lags below it are not searched, but still count towards the mean, so that the threshold does not depend on the note range.
+	 */
+	const auto first_lag = difference.min_lag();
+	for (size_t tau = 1; tau <= difference.max_lag(); ++tau) {
+		const float sum = difference(tau);
 		cumulative_mean += sum;
-		if (sum / (cumulative_mean / static_cast<float>(tau)) < threshold) {
+		if (tau >= first_lag && sum / (cumulative_mean / static_cast<float>(tau)) < threshold) {
 			// found a peak
 			const float freq = wavelength_to_freq(tau, conf.sample_rate);
 			pitch_estimate candidate {freq};
@@ -29,7 +33,7 @@ note_estimates yin::detect(const sample_buffer &in) {
 			 * But heuristically, continueing the search is probably not very fruitful
 			 * given that we found an invalid candidate, that is not even a note on the piano
 			 */
-			if (candidate.valid()) {
+			if (conf.note_in_range(freq_to_midi(freq))) {
 				result.push_back(note_estimate(candidate));
 			}
 
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "util/music.hpp"
+#include "difference_function.hpp"
 
 namespace fftune {
 
@@ -25,6 +25,7 @@ public:
 	note_estimates detect(const sample_buffer &in);
 private:
 	config conf;
+	difference_function difference;
 };
 
 }
@@ -1,4 +1,5 @@
 #include "music.hpp"
+#include "simd.hpp"
 
 namespace fftune {
 
@@ -28,19 +29,16 @@ void gen_harmonic(float freq0, float sample_rate, float *buf, size_t buf_size, s
 }
 
 float mean_volume(const sample_buffer &buf) {
-	float sum = 0.f;
-	for (size_t i = 0; i < buf.size; ++i) {
-		sum += std::abs(buf.data[i]);
-	}
-	return sum / buf.size;
+	return mean_volume(buf.data, buf.size);
+}
+
+float mean_volume(const float *data, size_t size) {
+	return simd::sum_abs(data, size) / size;
 }
 
 void match_volume(sample_buffer &buf, const float volume) {
 	const auto vol = mean_volume(buf);
-	const auto scalar = volume / vol;
-	for (size_t i = 0; i < buf.size; ++i) {
-		buf.data[i] = buf.data[i] * scalar;
-	}
+	simd::scale(buf.data, volume / vol, buf.size);
 }
 
 }
@@ -14,6 +14,7 @@ namespace fftune {
 void gen_sine(float freq, float sample_rate, float *buf, size_t buf_size);
 void gen_harmonic(float freq0, float sample_rate, float *buf, size_t buf_size, size_t overtones = 10, float linear_dampening = 0.4);
 float mean_volume(const sample_buffer &buf);
+float mean_volume(const float *data, size_t size);
 void match_volume(sample_buffer &buf, const float volume);
 
 }
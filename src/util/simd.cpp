@@ -0,0 +1,651 @@
+#include "simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FFTUNE_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace fftune {
+
+namespace simd {
+
+namespace {
+
+float scalar_squared_difference(const float *a, const float *b, size_t size) {
+	float sum = 0.f;
+	for (size_t i = 0; i < size; ++i) {
+		const auto diff = a[i] - b[i];
+		sum += diff * diff;
+	}
+	return sum;
+}
+
+float scalar_sum_abs(const float *data, size_t size) {
+	float sum = 0.f;
+	for (size_t i = 0; i < size; ++i) {
+		sum += std::abs(data[i]);
+	}
+	return sum;
+}
+
+void scalar_scale(float *data, float factor, size_t size) {
+	for (size_t i = 0; i < size; ++i) {
+		data[i] *= factor;
+	}
+}
+
+void scalar_multiply(const float *a, const float *b, float *dest, size_t size) {
+	for (size_t i = 0; i < size; ++i) {
+		dest[i] = a[i] * b[i];
+	}
+}
+
+void scalar_minmax(const float *data, size_t size, float &min, float &max) {
+	min = data[0];
+	max = data[0];
+	for (size_t i = 1; i < size; ++i) {
+		min = std::min(min, data[i]);
+		max = std::max(max, data[i]);
+	}
+}
+
+/**
+ * The blocked kernels only process the samples, that all lags of a block have in common,
+ * the remaining samples of each lag are left to the single lag kernels
+ */
+size_t common_length(size_t size, size_t tau) {
+	return size > tau + lag_block - 1 ? size - tau - (lag_block - 1) : 0;
+}
+
+size_t lag_length(size_t size, size_t tau) {
+	return size > tau ? size - tau : 0;
+}
+
+void scalar_squared_differences(const float *data, size_t size, size_t tau, float *out) {
+	const auto common = common_length(size, tau);
+	float sums[lag_block] = {};
+	for (size_t j = 0; j < common; ++j) {
+		for (size_t k = 0; k < lag_block; ++k) {
+			const auto diff = data[j] - data[j + tau + k];
+			sums[k] += diff * diff;
+		}
+	}
+	for (size_t k = 0; k < lag_block; ++k) {
+		out[k] = sums[k] + scalar_squared_difference(data + common, data + common + tau + k, lag_length(size, tau + k) - common);
+	}
+}
+
+void scalar_windowed_squared_differences(const float *x, const float *y, size_t count, std::ptrdiff_t step, float *out) {
+	for (size_t k = 0; k < lag_block; ++k) {
+		out[k] = scalar_squared_difference(x, y + static_cast<std::ptrdiff_t>(k) * step, count);
+	}
+}
+
+/**
+ * The rotating sums process several vectors of values at once,
+ * so that the multiplications of one phase do not have to wait for the previous step of the same phase
+ */
+constexpr const size_t phase_chains = 2;
+
+void scalar_rotating_sums(const float *samples, size_t count, const float *phase_re, const float *phase_im, const float *step_re, const float *step_im, float *sum_re, float *sum_im, size_t size) {
+	for (size_t i = 0; i < size; ++i) {
+		float re = phase_re[i];
+		float im = phase_im[i];
+		for (size_t m = 0; m < count; ++m) {
+			sum_re[i] += samples[m] * re;
+			sum_im[i] += samples[m] * im;
+			const auto next_re = re * step_re[i] - im * step_im[i];
+			im = re * step_im[i] + im * step_re[i];
+			re = next_re;
+		}
+	}
+}
+
+#ifdef FFTUNE_SIMD_X86
+
+/**
+ * Every instruction set processes as many whole vectors as possible and leaves the remaining samples to the scalar kernels.
+ * Sums use two accumulators, so that consecutive additions do not have to wait for each other.
+ * The wider kernels clear the upper halves of the vector registers before handing over to the narrower ones,
+ * otherwise every following instruction without the VEX encoding, including those of the C library, is slowed down.
+ */
+
+__attribute__((target("sse2"))) float horizontal_sum(__m128 v) {
+	const __m128 high = _mm_movehl_ps(v, v);
+	v = _mm_add_ps(v, high);
+	v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+	return _mm_cvtss_f32(v);
+}
+
+__attribute__((target("sse2"))) float sse2_squared_difference(const float *a, const float *b, size_t size) {
+	__m128 sum0 = _mm_setzero_ps();
+	__m128 sum1 = _mm_setzero_ps();
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		const __m128 d0 = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+		const __m128 d1 = _mm_sub_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4));
+		sum0 = _mm_add_ps(sum0, _mm_mul_ps(d0, d0));
+		sum1 = _mm_add_ps(sum1, _mm_mul_ps(d1, d1));
+	}
+	return horizontal_sum(_mm_add_ps(sum0, sum1)) + scalar_squared_difference(a + i, b + i, size - i);
+}
+
+__attribute__((target("sse2"))) float sse2_sum_abs(const float *data, size_t size) {
+	// clearing the sign bit yields the absolute value
+	const __m128 mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	__m128 sum0 = _mm_setzero_ps();
+	__m128 sum1 = _mm_setzero_ps();
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		sum0 = _mm_add_ps(sum0, _mm_and_ps(mask, _mm_loadu_ps(data + i)));
+		sum1 = _mm_add_ps(sum1, _mm_and_ps(mask, _mm_loadu_ps(data + i + 4)));
+	}
+	return horizontal_sum(_mm_add_ps(sum0, sum1)) + scalar_sum_abs(data + i, size - i);
+}
+
+__attribute__((target("sse2"))) void sse2_scale(float *data, float factor, size_t size) {
+	const __m128 f = _mm_set1_ps(factor);
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		_mm_storeu_ps(data + i, _mm_mul_ps(f, _mm_loadu_ps(data + i)));
+	}
+	scalar_scale(data + i, factor, size - i);
+}
+
+__attribute__((target("sse2"))) void sse2_multiply(const float *a, const float *b, float *dest, size_t size) {
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		_mm_storeu_ps(dest + i, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+	}
+	scalar_multiply(a + i, b + i, dest + i, size - i);
+}
+
+__attribute__((target("sse2"))) void sse2_minmax(const float *data, size_t size, float &min, float &max) {
+	if (size < 4) {
+		scalar_minmax(data, size, min, max);
+		return;
+	}
+	// the last vector overlaps the previous one instead of leaving a tail
+	__m128 low = _mm_loadu_ps(data);
+	__m128 high = low;
+	for (size_t i = 4; i < size; i += 4) {
+		const __m128 v = _mm_loadu_ps(data + std::min(i, size - 4));
+		low = _mm_min_ps(low, v);
+		high = _mm_max_ps(high, v);
+	}
+	alignas(16) float lows[4];
+	alignas(16) float highs[4];
+	_mm_store_ps(lows, low);
+	_mm_store_ps(highs, high);
+	min = *std::min_element(lows, lows + 4);
+	max = *std::max_element(highs, highs + 4);
+}
+
+__attribute__((target("sse2"))) void sse2_squared_differences(const float *data, size_t size, size_t tau, float *out) {
+	const auto common = common_length(size, tau);
+	__m128 sums[lag_block];
+	for (auto &sum : sums) {
+		sum = _mm_setzero_ps();
+	}
+	size_t j = 0;
+	for (; j + 4 <= common; j += 4) {
+		const __m128 x = _mm_loadu_ps(data + j);
+#pragma GCC unroll 16
+		for (size_t k = 0; k < lag_block; ++k) {
+			const __m128 d = _mm_sub_ps(x, _mm_loadu_ps(data + j + tau + k));
+			sums[k] = _mm_add_ps(sums[k], _mm_mul_ps(d, d));
+		}
+	}
+	for (size_t k = 0; k < lag_block; ++k) {
+		out[k] = horizontal_sum(sums[k]) + sse2_squared_difference(data + j, data + j + tau + k, lag_length(size, tau + k) - j);
+	}
+}
+
+__attribute__((target("sse2"))) void sse2_windowed_squared_differences(const float *x, const float *y, size_t count, std::ptrdiff_t step, float *out) {
+	__m128 sums[lag_block];
+	for (auto &sum : sums) {
+		sum = _mm_setzero_ps();
+	}
+	size_t j = 0;
+	for (; j + 4 <= count; j += 4) {
+		const __m128 v = _mm_loadu_ps(x + j);
+#pragma GCC unroll 16
+		for (size_t k = 0; k < lag_block; ++k) {
+			const __m128 d = _mm_sub_ps(v, _mm_loadu_ps(y + j + static_cast<std::ptrdiff_t>(k) * step));
+			sums[k] = _mm_add_ps(sums[k], _mm_mul_ps(d, d));
+		}
+	}
+	for (size_t k = 0; k < lag_block; ++k) {
+		out[k] = horizontal_sum(sums[k]) + scalar_squared_difference(x + j, y + j + static_cast<std::ptrdiff_t>(k) * step, count - j);
+	}
+}
+
+__attribute__((target("sse2"))) void sse2_rotating_sums(const float *samples, size_t count, const float *phase_re, const float *phase_im, const float *step_re, const float *step_im, float *sum_re, float *sum_im, size_t size) {
+	constexpr const size_t width = 4;
+	size_t i = 0;
+	for (; i + phase_chains * width <= size; i += phase_chains * width) {
+		__m128 re[phase_chains], im[phase_chains], s_re[phase_chains], s_im[phase_chains], a_re[phase_chains], a_im[phase_chains];
+		for (size_t c = 0; c < phase_chains; ++c) {
+			const auto j = i + c * width;
+			re[c] = _mm_loadu_ps(phase_re + j);
+			im[c] = _mm_loadu_ps(phase_im + j);
+			s_re[c] = _mm_loadu_ps(step_re + j);
+			s_im[c] = _mm_loadu_ps(step_im + j);
+			a_re[c] = _mm_loadu_ps(sum_re + j);
+			a_im[c] = _mm_loadu_ps(sum_im + j);
+		}
+		for (size_t m = 0; m < count; ++m) {
+			const __m128 x = _mm_set1_ps(samples[m]);
+#pragma GCC unroll 4
+			for (size_t c = 0; c < phase_chains; ++c) {
+				a_re[c] = _mm_add_ps(a_re[c], _mm_mul_ps(x, re[c]));
+				a_im[c] = _mm_add_ps(a_im[c], _mm_mul_ps(x, im[c]));
+				const __m128 next_re = _mm_sub_ps(_mm_mul_ps(re[c], s_re[c]), _mm_mul_ps(im[c], s_im[c]));
+				im[c] = _mm_add_ps(_mm_mul_ps(re[c], s_im[c]), _mm_mul_ps(im[c], s_re[c]));
+				re[c] = next_re;
+			}
+		}
+		for (size_t c = 0; c < phase_chains; ++c) {
+			_mm_storeu_ps(sum_re + i + c * width, a_re[c]);
+			_mm_storeu_ps(sum_im + i + c * width, a_im[c]);
+		}
+	}
+	scalar_rotating_sums(samples, count, phase_re + i, phase_im + i, step_re + i, step_im + i, sum_re + i, sum_im + i, size - i);
+}
+
+__attribute__((target("avx2,fma"))) float avx2_squared_difference(const float *a, const float *b, size_t size) {
+	__m256 sum0 = _mm256_setzero_ps();
+	__m256 sum1 = _mm256_setzero_ps();
+	size_t i = 0;
+	for (; i + 16 <= size; i += 16) {
+		const __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+		const __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8));
+		sum0 = _mm256_fmadd_ps(d0, d0, sum0);
+		sum1 = _mm256_fmadd_ps(d1, d1, sum1);
+	}
+	const __m256 sum = _mm256_add_ps(sum0, sum1);
+	const float head = horizontal_sum(_mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1)));
+	_mm256_zeroupper();
+	return head + sse2_squared_difference(a + i, b + i, size - i);
+}
+
+__attribute__((target("avx2"))) float avx2_sum_abs(const float *data, size_t size) {
+	const __m256 mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+	__m256 sum0 = _mm256_setzero_ps();
+	__m256 sum1 = _mm256_setzero_ps();
+	size_t i = 0;
+	for (; i + 16 <= size; i += 16) {
+		sum0 = _mm256_add_ps(sum0, _mm256_and_ps(mask, _mm256_loadu_ps(data + i)));
+		sum1 = _mm256_add_ps(sum1, _mm256_and_ps(mask, _mm256_loadu_ps(data + i + 8)));
+	}
+	const __m256 sum = _mm256_add_ps(sum0, sum1);
+	const float head = horizontal_sum(_mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1)));
+	_mm256_zeroupper();
+	return head + sse2_sum_abs(data + i, size - i);
+}
+
+__attribute__((target("avx2"))) void avx2_scale(float *data, float factor, size_t size) {
+	const __m256 f = _mm256_set1_ps(factor);
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		_mm256_storeu_ps(data + i, _mm256_mul_ps(f, _mm256_loadu_ps(data + i)));
+	}
+	_mm256_zeroupper();
+	sse2_scale(data + i, factor, size - i);
+}
+
+__attribute__((target("avx2"))) void avx2_multiply(const float *a, const float *b, float *dest, size_t size) {
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		_mm256_storeu_ps(dest + i, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+	}
+	_mm256_zeroupper();
+	sse2_multiply(a + i, b + i, dest + i, size - i);
+}
+
+__attribute__((target("avx2"))) void avx2_minmax(const float *data, size_t size, float &min, float &max) {
+	if (size < 8) {
+		sse2_minmax(data, size, min, max);
+		return;
+	}
+	// the last vector overlaps the previous one instead of leaving a tail
+	__m256 low = _mm256_loadu_ps(data);
+	__m256 high = low;
+	for (size_t i = 8; i < size; i += 8) {
+		const __m256 v = _mm256_loadu_ps(data + std::min(i, size - 8));
+		low = _mm256_min_ps(low, v);
+		high = _mm256_max_ps(high, v);
+	}
+	alignas(32) float lows[8];
+	alignas(32) float highs[8];
+	_mm256_store_ps(lows, low);
+	_mm256_store_ps(highs, high);
+	min = *std::min_element(lows, lows + 8);
+	max = *std::max_element(highs, highs + 8);
+}
+
+__attribute__((target("avx2,fma"))) void avx2_squared_differences(const float *data, size_t size, size_t tau, float *out) {
+	const auto common = common_length(size, tau);
+	__m256 sums[lag_block];
+	for (auto &sum : sums) {
+		sum = _mm256_setzero_ps();
+	}
+	size_t j = 0;
+	for (; j + 8 <= common; j += 8) {
+		const __m256 x = _mm256_loadu_ps(data + j);
+#pragma GCC unroll 16
+		for (size_t k = 0; k < lag_block; ++k) {
+			const __m256 d = _mm256_sub_ps(x, _mm256_loadu_ps(data + j + tau + k));
+			sums[k] = _mm256_fmadd_ps(d, d, sums[k]);
+		}
+	}
+	for (size_t k = 0; k < lag_block; ++k) {
+		out[k] = horizontal_sum(_mm_add_ps(_mm256_castps256_ps128(sums[k]), _mm256_extractf128_ps(sums[k], 1)));
+	}
+	_mm256_zeroupper();
+	for (size_t k = 0; k < lag_block; ++k) {
+		out[k] += sse2_squared_difference(data + j, data + j + tau + k, lag_length(size, tau + k) - j);
+	}
+}
+
+__attribute__((target("avx2,fma"))) void avx2_windowed_squared_differences(const float *x, const float *y, size_t count, std::ptrdiff_t step, float *out) {
+	__m256 sums[lag_block];
+	for (auto &sum : sums) {
+		sum = _mm256_setzero_ps();
+	}
+	size_t j = 0;
+	for (; j + 8 <= count; j += 8) {
+		const __m256 v = _mm256_loadu_ps(x + j);
+#pragma GCC unroll 16
+		for (size_t k = 0; k < lag_block; ++k) {
+			const __m256 d = _mm256_sub_ps(v, _mm256_loadu_ps(y + j + static_cast<std::ptrdiff_t>(k) * step));
+			sums[k] = _mm256_fmadd_ps(d, d, sums[k]);
+		}
+	}
+	for (size_t k = 0; k < lag_block; ++k) {
+		out[k] = horizontal_sum(_mm_add_ps(_mm256_castps256_ps128(sums[k]), _mm256_extractf128_ps(sums[k], 1)));
+	}
+	_mm256_zeroupper();
+	for (size_t k = 0; k < lag_block; ++k) {
+		out[k] += sse2_squared_difference(x + j, y + j + static_cast<std::ptrdiff_t>(k) * step, count - j);
+	}
+}
+
+__attribute__((target("avx2,fma"))) void avx2_rotating_sums(const float *samples, size_t count, const float *phase_re, const float *phase_im, const float *step_re, const float *step_im, float *sum_re, float *sum_im, size_t size) {
+	constexpr const size_t width = 8;
+	size_t i = 0;
+	for (; i + phase_chains * width <= size; i += phase_chains * width) {
+		__m256 re[phase_chains], im[phase_chains], s_re[phase_chains], s_im[phase_chains], a_re[phase_chains], a_im[phase_chains];
+		for (size_t c = 0; c < phase_chains; ++c) {
+			const auto j = i + c * width;
+			re[c] = _mm256_loadu_ps(phase_re + j);
+			im[c] = _mm256_loadu_ps(phase_im + j);
+			s_re[c] = _mm256_loadu_ps(step_re + j);
+			s_im[c] = _mm256_loadu_ps(step_im + j);
+			a_re[c] = _mm256_loadu_ps(sum_re + j);
+			a_im[c] = _mm256_loadu_ps(sum_im + j);
+		}
+		for (size_t m = 0; m < count; ++m) {
+			const __m256 x = _mm256_set1_ps(samples[m]);
+#pragma GCC unroll 4
+			for (size_t c = 0; c < phase_chains; ++c) {
+				a_re[c] = _mm256_fmadd_ps(x, re[c], a_re[c]);
+				a_im[c] = _mm256_fmadd_ps(x, im[c], a_im[c]);
+				const __m256 next_re = _mm256_fmsub_ps(re[c], s_re[c], _mm256_mul_ps(im[c], s_im[c]));
+				im[c] = _mm256_fmadd_ps(re[c], s_im[c], _mm256_mul_ps(im[c], s_re[c]));
+				re[c] = next_re;
+			}
+		}
+		for (size_t c = 0; c < phase_chains; ++c) {
+			_mm256_storeu_ps(sum_re + i + c * width, a_re[c]);
+			_mm256_storeu_ps(sum_im + i + c * width, a_im[c]);
+		}
+	}
+	_mm256_zeroupper();
+	sse2_rotating_sums(samples, count, phase_re + i, phase_im + i, step_re + i, step_im + i, sum_re + i, sum_im + i, size - i);
+}
+
+/**
+ * AVX-512 can mask single lanes of loads and stores,
+ * so the remaining samples are handled by a final masked vector instead of the scalar kernels
+ */
+
+__attribute__((target("avx512f"))) __mmask16 tail_mask(size_t remaining) {
+	return static_cast<__mmask16>((1u << remaining) - 1u);
+}
+
+/**
+ * GCC fills the unused operands of many AVX-512 intrinsics, like the reductions and extractions, with uninitialized registers and then warns about them.
+ * So vectors are reduced through memory and minima and maxima are taken with masks, that select every lane.
+ */
+
+__attribute__((target("avx512f"))) float horizontal_sum(__m512 v) {
+	alignas(64) float lanes[16];
+	_mm512_store_ps(lanes, v);
+	const __m256 half = _mm256_add_ps(_mm256_load_ps(lanes), _mm256_load_ps(lanes + 8));
+	return horizontal_sum(_mm_add_ps(_mm256_castps256_ps128(half), _mm256_extractf128_ps(half, 1)));
+}
+
+__attribute__((target("avx512f"))) float avx512_squared_difference(const float *a, const float *b, size_t size) {
+	__m512 sum0 = _mm512_setzero_ps();
+	__m512 sum1 = _mm512_setzero_ps();
+	size_t i = 0;
+	for (; i + 32 <= size; i += 32) {
+		const __m512 d0 = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+		const __m512 d1 = _mm512_sub_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16));
+		sum0 = _mm512_fmadd_ps(d0, d0, sum0);
+		sum1 = _mm512_fmadd_ps(d1, d1, sum1);
+	}
+	for (; i < size; i += 16) {
+		const auto mask = size - i >= 16 ? static_cast<__mmask16>(0xffff) : tail_mask(size - i);
+		const __m512 d = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i));
+		sum0 = _mm512_fmadd_ps(d, d, sum0);
+	}
+	return horizontal_sum(_mm512_add_ps(sum0, sum1));
+}
+
+__attribute__((target("avx512f"))) float avx512_sum_abs(const float *data, size_t size) {
+	__m512 sum0 = _mm512_setzero_ps();
+	__m512 sum1 = _mm512_setzero_ps();
+	size_t i = 0;
+	for (; i + 32 <= size; i += 32) {
+		sum0 = _mm512_add_ps(sum0, _mm512_abs_ps(_mm512_loadu_ps(data + i)));
+		sum1 = _mm512_add_ps(sum1, _mm512_abs_ps(_mm512_loadu_ps(data + i + 16)));
+	}
+	for (; i < size; i += 16) {
+		const auto mask = size - i >= 16 ? static_cast<__mmask16>(0xffff) : tail_mask(size - i);
+		sum0 = _mm512_add_ps(sum0, _mm512_abs_ps(_mm512_maskz_loadu_ps(mask, data + i)));
+	}
+	return horizontal_sum(_mm512_add_ps(sum0, sum1));
+}
+
+__attribute__((target("avx512f"))) void avx512_scale(float *data, float factor, size_t size) {
+	const __m512 f = _mm512_set1_ps(factor);
+	for (size_t i = 0; i < size; i += 16) {
+		const auto mask = size - i >= 16 ? static_cast<__mmask16>(0xffff) : tail_mask(size - i);
+		_mm512_mask_storeu_ps(data + i, mask, _mm512_mul_ps(f, _mm512_maskz_loadu_ps(mask, data + i)));
+	}
+}
+
+__attribute__((target("avx512f"))) void avx512_multiply(const float *a, const float *b, float *dest, size_t size) {
+	for (size_t i = 0; i < size; i += 16) {
+		const auto mask = size - i >= 16 ? static_cast<__mmask16>(0xffff) : tail_mask(size - i);
+		_mm512_mask_storeu_ps(dest + i, mask, _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i)));
+	}
+}
+
+__attribute__((target("avx512f"))) void avx512_minmax(const float *data, size_t size, float &min, float &max) {
+	if (size < 16) {
+		avx2_minmax(data, size, min, max);
+		return;
+	}
+	// the last vector overlaps the previous one instead of leaving a tail
+	__m512 low = _mm512_loadu_ps(data);
+	__m512 high = low;
+	for (size_t i = 16; i < size; i += 16) {
+		const __m512 v = _mm512_loadu_ps(data + std::min(i, size - 16));
+		low = _mm512_mask_min_ps(low, 0xffff, low, v);
+		high = _mm512_mask_max_ps(high, 0xffff, high, v);
+	}
+	alignas(64) float lows[16];
+	alignas(64) float highs[16];
+	_mm512_store_ps(lows, low);
+	_mm512_store_ps(highs, high);
+	min = *std::min_element(lows, lows + 16);
+	max = *std::max_element(highs, highs + 16);
+}
+
+__attribute__((target("avx512f"))) void avx512_squared_differences(const float *data, size_t size, size_t tau, float *out) {
+	const auto common = common_length(size, tau);
+	__m512 sums[lag_block];
+	for (auto &sum : sums) {
+		sum = _mm512_setzero_ps();
+	}
+	size_t j = 0;
+	for (; j + 16 <= common; j += 16) {
+		const __m512 x = _mm512_loadu_ps(data + j);
+#pragma GCC unroll 16
+		for (size_t k = 0; k < lag_block; ++k) {
+			const __m512 d = _mm512_sub_ps(x, _mm512_loadu_ps(data + j + tau + k));
+			sums[k] = _mm512_fmadd_ps(d, d, sums[k]);
+		}
+	}
+	for (size_t k = 0; k < lag_block; ++k) {
+		out[k] = horizontal_sum(sums[k]) + avx512_squared_difference(data + j, data + j + tau + k, lag_length(size, tau + k) - j);
+	}
+}
+
+__attribute__((target("avx512f"))) void avx512_windowed_squared_differences(const float *x, const float *y, size_t count, std::ptrdiff_t step, float *out) {
+	__m512 sums[lag_block];
+	for (auto &sum : sums) {
+		sum = _mm512_setzero_ps();
+	}
+	for (size_t j = 0; j < count; j += 16) {
+		const auto mask = count - j >= 16 ? static_cast<__mmask16>(0xffff) : tail_mask(count - j);
+		const __m512 v = _mm512_maskz_loadu_ps(mask, x + j);
+#pragma GCC unroll 16
+		for (size_t k = 0; k < lag_block; ++k) {
+			const __m512 d = _mm512_sub_ps(v, _mm512_maskz_loadu_ps(mask, y + j + static_cast<std::ptrdiff_t>(k) * step));
+			sums[k] = _mm512_fmadd_ps(d, d, sums[k]);
+		}
+	}
+	for (size_t k = 0; k < lag_block; ++k) {
+		out[k] = horizontal_sum(sums[k]);
+	}
+}
+
+__attribute__((target("avx512f"))) void avx512_rotating_sums(const float *samples, size_t count, const float *phase_re, const float *phase_im, const float *step_re, const float *step_im, float *sum_re, float *sum_im, size_t size) {
+	constexpr const size_t width = 16;
+	size_t i = 0;
+	for (; i + phase_chains * width <= size; i += phase_chains * width) {
+		__m512 re[phase_chains], im[phase_chains], s_re[phase_chains], s_im[phase_chains], a_re[phase_chains], a_im[phase_chains];
+		for (size_t c = 0; c < phase_chains; ++c) {
+			const auto j = i + c * width;
+			re[c] = _mm512_loadu_ps(phase_re + j);
+			im[c] = _mm512_loadu_ps(phase_im + j);
+			s_re[c] = _mm512_loadu_ps(step_re + j);
+			s_im[c] = _mm512_loadu_ps(step_im + j);
+			a_re[c] = _mm512_loadu_ps(sum_re + j);
+			a_im[c] = _mm512_loadu_ps(sum_im + j);
+		}
+		for (size_t m = 0; m < count; ++m) {
+			const __m512 x = _mm512_set1_ps(samples[m]);
+#pragma GCC unroll 4
+			for (size_t c = 0; c < phase_chains; ++c) {
+				a_re[c] = _mm512_fmadd_ps(x, re[c], a_re[c]);
+				a_im[c] = _mm512_fmadd_ps(x, im[c], a_im[c]);
+				const __m512 next_re = _mm512_fmsub_ps(re[c], s_re[c], _mm512_mul_ps(im[c], s_im[c]));
+				im[c] = _mm512_fmadd_ps(re[c], s_im[c], _mm512_mul_ps(im[c], s_re[c]));
+				re[c] = next_re;
+			}
+		}
+		for (size_t c = 0; c < phase_chains; ++c) {
+			_mm512_storeu_ps(sum_re + i + c * width, a_re[c]);
+			_mm512_storeu_ps(sum_im + i + c * width, a_im[c]);
+		}
+	}
+	_mm256_zeroupper();
+	avx2_rotating_sums(samples, count, phase_re + i, phase_im + i, step_re + i, step_im + i, sum_re + i, sum_im + i, size - i);
+}
+
+#endif
+
+constexpr const kernels scalar_kernels {scalar_squared_difference, scalar_squared_differences, scalar_windowed_squared_differences, scalar_rotating_sums, scalar_sum_abs, scalar_scale, scalar_multiply, scalar_minmax};
+#ifdef FFTUNE_SIMD_X86
+constexpr const kernels sse2_kernels {sse2_squared_difference, sse2_squared_differences, sse2_windowed_squared_differences, sse2_rotating_sums, sse2_sum_abs, sse2_scale, sse2_multiply, sse2_minmax};
+constexpr const kernels avx2_kernels {avx2_squared_difference, avx2_squared_differences, avx2_windowed_squared_differences, avx2_rotating_sums, avx2_sum_abs, avx2_scale, avx2_multiply, avx2_minmax};
+constexpr const kernels avx512_kernels {avx512_squared_difference, avx512_squared_differences, avx512_windowed_squared_differences, avx512_rotating_sums, avx512_sum_abs, avx512_scale, avx512_multiply, avx512_minmax};
+#endif
+
+}
+
+bool supported(instruction_set set) {
+#ifdef FFTUNE_SIMD_X86
+	switch (set) {
+	case instruction_set::Scalar:
+		return true;
+	case instruction_set::Sse2:
+		return __builtin_cpu_supports("sse2");
+	case instruction_set::Avx2:
+		// the AVX2 kernels use fused multiply-add, which came with the same processors
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	case instruction_set::Avx512:
+		// the AVX-512 kernels hand their remaining samples over to the AVX2 kernels
+		return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	default:
+		return false;
+	}
+#else
+	return set == instruction_set::Scalar;
+#endif
+}
+
+instruction_set best_instruction_set() {
+	for (const auto set : {instruction_set::Avx512, instruction_set::Avx2, instruction_set::Sse2}) {
+		if (supported(set)) {
+			return set;
+		}
+	}
+	return instruction_set::Scalar;
+}
+
+const kernels &get(instruction_set set) {
+#ifdef FFTUNE_SIMD_X86
+	switch (set) {
+	case instruction_set::Sse2:
+		return sse2_kernels;
+	case instruction_set::Avx2:
+		return avx2_kernels;
+	case instruction_set::Avx512:
+		return avx512_kernels;
+	default:
+		break;
+	}
+#endif
+	return scalar_kernels;
+}
+
+const kernels &active() {
+	// detecting the CPU features only happens once, and is thread-safe
+	static const kernels &best = get(best_instruction_set());
+	return best;
+}
+
+const char *to_string(instruction_set set) {
+	switch (set) {
+	case instruction_set::Sse2:
+		return "sse2";
+	case instruction_set::Avx2:
+		return "avx2";
+	case instruction_set::Avx512:
+		return "avx512";
+	default:
+		return "scalar";
+	}
+}
+
+}
+}
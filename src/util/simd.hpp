@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+
+namespace fftune {
+
+namespace simd {
+
+/**
+ * @brief An instruction set for vectorized kernels
+ *
+ * The instruction sets are ordered, a later one is preferred over an earlier one if the CPU supports it
+ */
+enum class instruction_set {
+	Scalar,
+	Sse2,
+	Avx2,
+	Avx512,
+};
+
+/**
+ * @brief The number of lags computed at once by kernels::squared_differences
+ *
+ * All lags of a block share a single pass over the samples and keep their partial sums in registers.
+ * Larger blocks save more loads, but need more registers.
+ */
+constexpr const size_t lag_block = 8;
+
+/**
+ * @brief A set of vectorized kernels
+ *
+ * Holds the implementation of every kernel for a single instruction set
+ */
+struct kernels {
+	/**
+	 * @brief Returns \f$\sum_i (a_i - b_i)^2\f$ over \p size samples
+	 */
+	float (*squared_difference)(const float *a, const float *b, size_t size);
+	/**
+	 * @brief Writes \f$\sum_j (x_j - x_{j + \tau})^2\f$ over \p size samples of \p data for the lag_block lags starting at \p tau to \p out
+	 *
+	 * Lags of at least \p size samples are 0
+	 */
+	void (*squared_differences)(const float *data, size_t size, size_t tau, float *out);
+	/**
+	 * @brief Writes \f$\sum_j (x_j - y_{j + k \cdot step})^2\f$ over \p count samples for the lag_block offsets \f$k\f$ to \p out
+	 *
+	 * Unlike squared_differences, every offset sums the same number of samples.
+	 * With a \p step of -1, the samples of \p y before the pointer are read as well.
+	 */
+	void (*windowed_squared_differences)(const float *x, const float *y, size_t count, std::ptrdiff_t step, float *out);
+	/**
+	 * @brief Adds rotating sums of samples to \p size complex values
+	 *
+	 * Adds \f$\sum_m x_m p_i s_i^m\f$ over \p count samples of \p samples to the value \f$i\f$,
+	 * whose real and imaginary parts are stored in \p sum_re and \p sum_im.
+	 * The start phases \f$p_i\f$ and the steps \f$s_i\f$ are given by their real and imaginary parts as well.
+	 * The steps are applied by repeated multiplication, so \p count should be small to keep rounding errors small.
+	 */
+	void (*rotating_sums)(const float *samples, size_t count, const float *phase_re, const float *phase_im, const float *step_re, const float *step_im, float *sum_re, float *sum_im, size_t size);
+	/**
+	 * @brief Returns \f$\sum_i |x_i|\f$ over \p size samples of \p data
+	 */
+	float (*sum_abs)(const float *data, size_t size);
+	/**
+	 * @brief Multiplies \p size samples of \p data by \p factor in place
+	 */
+	void (*scale)(float *data, float factor, size_t size);
+	/**
+	 * @brief Writes the products of \p size samples of \p a and \p b to \p dest
+	 */
+	void (*multiply)(const float *a, const float *b, float *dest, size_t size);
+	/**
+	 * @brief Writes the minimum and maximum of \p size samples of \p data to \p min and \p max, \p size must not be zero
+	 */
+	void (*minmax)(const float *data, size_t size, float &min, float &max);
+};
+
+/**
+ * @brief Checks if an instruction set can be used
+ *
+ * Returns \c true iff the CPU this runs on supports \p set and the library was built with kernels for it
+ */
+bool supported(instruction_set set);
+/**
+ * @brief Returns the best instruction set
+ *
+ * This is the latest instruction set, that is supported()
+ */
+instruction_set best_instruction_set();
+/**
+ * @brief Returns the kernels of an instruction set
+ *
+ * Returns the kernels for \p set, which must be supported()
+ */
+const kernels &get(instruction_set set);
+/**
+ * @brief Returns the kernels used by the library
+ *
+ * These are the kernels of best_instruction_set(), which is detected once on the first call
+ */
+const kernels &active();
+/**
+ * @brief Returns the name of an instruction set
+ *
+ * This can be useful for logging and benchmarks
+ */
+const char *to_string(instruction_set set);
+
+inline float squared_difference(const float *a, const float *b, size_t size) {
+	return active().squared_difference(a, b, size);
+}
+inline void squared_differences(const float *data, size_t size, size_t tau, float *out) {
+	active().squared_differences(data, size, tau, out);
+}
+inline void windowed_squared_differences(const float *x, const float *y, size_t count, std::ptrdiff_t step, float *out) {
+	active().windowed_squared_differences(x, y, count, step, out);
+}
+inline void rotating_sums(const float *samples, size_t count, const float *phase_re, const float *phase_im, const float *step_re, const float *step_im, float *sum_re, float *sum_im, size_t size) {
+	active().rotating_sums(samples, count, phase_re, phase_im, step_re, step_im, sum_re, sum_im, size);
+}
+inline float sum_abs(const float *data, size_t size) {
+	return active().sum_abs(data, size);
+}
+inline void scale(float *data, float factor, size_t size) {
+	active().scale(data, factor, size);
+}
+inline void multiply(const float *a, const float *b, float *dest, size_t size) {
+	active().multiply(a, b, dest, size);
+}
+inline void minmax(const float *data, size_t size, float &min, float &max) {
+	active().minmax(data, size, min, max);
+}
+
+}
+}
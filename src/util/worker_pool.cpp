@@ -0,0 +1,36 @@
+#include "worker_pool.hpp"
+
+#include <algorithm>
+
+namespace fftune {
+
+worker_pool::worker_pool(size_t num_workers)
+	: start(std::max<size_t>(num_workers, 1)), done(std::max<size_t>(num_workers, 1)) {
+	for (size_t worker = 1; worker < num_workers; ++worker) {
+		threads.emplace_back([this, worker] { work(worker); });
+	}
+}
+
+worker_pool::~worker_pool() {
+	// the barriers order this write before the threads read it
+	stopping = true;
+	start.arrive_and_wait();
+	// jthreads join on destruction
+}
+
+size_t worker_pool::size() const {
+	return threads.size() + 1;
+}
+
+void worker_pool::work(size_t worker) {
+	while (true) {
+		start.arrive_and_wait();
+		if (stopping) {
+			return;
+		}
+		invoke(context, worker);
+		done.arrive_and_wait();
+	}
+}
+
+}
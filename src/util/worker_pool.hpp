@@ -0,0 +1,58 @@
+#pragma once
+
+#include <barrier>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace fftune {
+
+/**
+ * @brief A fixed set of worker threads
+ *
+ * The threads are started once and then wait for tasks, so that running a task does not pay for creating and joining threads.
+ * Tasks are handed out and collected with barriers, the calling thread takes part in every task as the first worker.
+ */
+class worker_pool {
+public:
+	/**
+	 * @brief Constructs a worker_pool
+	 *
+	 * Starts \p num_workers - 1 threads, the calling thread of run() is the remaining worker
+	 */
+	explicit worker_pool(size_t num_workers);
+	/**
+	 * @brief Stops and joins all threads
+	 */
+	~worker_pool();
+	worker_pool(const worker_pool &) = delete;
+	worker_pool &operator=(const worker_pool &) = delete;
+	/**
+	 * @brief Returns the number of workers, including the calling thread
+	 */
+	size_t size() const;
+	/**
+	 * @brief Runs a task on all workers
+	 *
+	 * Calls \p task with the index of every worker, from 0 to size() - 1, the index 0 is run on the calling thread.
+	 * Returns once all workers have finished.
+	 */
+	template<typename F>
+	void run(F &&task) {
+		context = &task;
+		invoke = [](void *context, size_t worker) { (*static_cast<std::remove_reference_t<F> *>(context))(worker); };
+		start.arrive_and_wait();
+		task(0);
+		done.arrive_and_wait();
+	}
+private:
+	void work(size_t worker);
+	std::barrier<> start;
+	std::barrier<> done;
+	void *context = nullptr;
+	void (*invoke)(void *context, size_t worker) = nullptr;
+	bool stopping = false;
+	std::vector<std::jthread> threads;
+};
+
+}
@@ -0,0 +1,106 @@
+#include "tests.hpp"
+
+class BinTest : public ::testing::Test {
+protected:
+	fftune::sample_buffer buf {tests::config.buffer_size};
+	std::vector<float> magnitudes;
+	void SetUp() override {
+		fftune::tone_generator gen;
+		gen.init(tests::config.buffer_size, tests::config.sample_rate, "");
+		gen.gen_harmonics(buf, {fftune::note_estimate(fftune::MidiA4)});
+		fftune::fft fft {tests::config.buffer_size, tests::config.sample_rate};
+		magnitudes = fft.detect_spectrum(buf).magnitudes;
+	}
+};
+
+// calls f with the first and last index of the window around every index
+template<typename F>
+void naive_windows(size_t size, size_t before, size_t after, F f) {
+	for (size_t i = 0; i < size; ++i) {
+		f(i, i >= before ? i - before : 0, std::min(i + after, size));
+	}
+}
+
+TEST_F(BinTest, SlidingStatistics) {
+	// the sliding statistics must match computing every window from scratch
+	const auto size = magnitudes.size();
+	std::vector<float> mean(size), deviation(size), max(size), min(size);
+	for (const auto &[before, after] : {std::pair<size_t, size_t>(5, 5), {40, 10}, {0, 1}, {100, 3}}) {
+		fftune::sliding_mean(magnitudes, before, after, mean);
+		fftune::sliding_standard_deviation(magnitudes, before, after, deviation);
+		fftune::sliding_max(magnitudes, before, after, max);
+		fftune::sliding_min(magnitudes, before, after, min);
+		naive_windows(size, before, after, [&](size_t i, size_t first, size_t last) {
+			const auto window = std::span(magnitudes).subspan(first, last - first);
+			double sum = 0.0;
+			for (const auto m : window) {
+				sum += m;
+			}
+			const auto expected_mean = sum / window.size();
+			EXPECT_NEAR(expected_mean, mean[i], 1e-3f);
+			if (window.size() > 1) {
+				double squares = 0.0;
+				for (const auto m : window) {
+					squares += (m - expected_mean) * (m - expected_mean);
+				}
+				EXPECT_NEAR(std::sqrt(squares / (window.size() - 1)), deviation[i], 1e-3f);
+			}
+			EXPECT_EQ(*std::ranges::max_element(window), max[i]);
+			EXPECT_EQ(*std::ranges::min_element(window), min[i]);
+		});
+	}
+}
+
+TEST_F(BinTest, NormalizeSin) {
+	// normalizing must match the local mean and maximum deviation computed for every bin from scratch
+	const auto size = magnitudes.size();
+	const size_t local_width = size / 300;
+	std::vector<float> normalized(size);
+	fftune::bins_normalize_sin(magnitudes, normalized);
+	naive_windows(size, local_width, local_width, [&](size_t i, size_t first, size_t last) {
+		float local_mean = 0.f;
+		for (size_t j = first; j < last; ++j) {
+			local_mean += magnitudes[j];
+		}
+		local_mean /= last - first;
+		float max_deviation = 0.f;
+		for (size_t j = first; j < last; ++j) {
+			max_deviation = std::max(max_deviation, std::abs(magnitudes[j] - local_mean));
+		}
+		EXPECT_NEAR((magnitudes[i] - local_mean) / max_deviation, normalized[i], 1e-4f);
+	});
+}
+
+TEST_F(BinTest, Distance) {
+	// the distance must match comparing the standardized neighbourhood of every bin from scratch
+	fftune::fft fft {tests::config.buffer_size, tests::config.sample_rate};
+	const auto a = fft.detect(buf);
+	fftune::tone_generator gen;
+	gen.init(tests::config.buffer_size, tests::config.sample_rate, "");
+	gen.gen_harmonics(buf, {fftune::note_estimate(fftune::MidiA4 - 7)});
+	const auto b = fft.detect(buf);
+
+	float expected = 0.f;
+	naive_windows(a.size(), 40, 10, [&](size_t i, size_t first, size_t last) {
+		float mean_a = 0.f;
+		float mean_b = 0.f;
+		for (size_t j = first; j < last; ++j) {
+			mean_a += a[j].magnitude;
+			mean_b += b[j].magnitude;
+		}
+		mean_a /= last - first;
+		mean_b /= last - first;
+		float deviation_a = 0.f;
+		float deviation_b = 0.f;
+		for (size_t j = first; j < last; ++j) {
+			deviation_a += (a[j].magnitude - mean_a) * (a[j].magnitude - mean_a);
+			deviation_b += (b[j].magnitude - mean_b) * (b[j].magnitude - mean_b);
+		}
+		deviation_a = std::sqrt(deviation_a / (last - first - 1));
+		deviation_b = std::sqrt(deviation_b / (last - first - 1));
+		const auto delta = (a[i].magnitude - mean_a) / deviation_a - (b[i].magnitude - mean_b) / deviation_b;
+		expected += delta * delta * delta * delta;
+	});
+	EXPECT_NEAR(expected, fftune::bins_distance(a, b), 1e-3f * expected);
+	EXPECT_EQ(0.f, fftune::bins_distance(a, a));
+}
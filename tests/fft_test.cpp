@@ -1,3 +1,7 @@
+#include <thread>
+
+#include "fft/builtin_fft.hpp"
+#include "fft/window.hpp"
 #include "tests.hpp"
 
 class FftTest : public ::testing::Test {
@@ -31,6 +35,52 @@ TEST_F(FftTest, Peak) {
 	check_bins(bins);
 }
 
+TEST_F(FftTest, Peaks) {
+	// the peaks must be local maxima, and the loudest one must be closer to the true frequency than any bin
+	auto fft = fftune::fft(tests::config.buffer_size, tests::config.sample_rate);
+	const float resolution = tests::config.sample_rate / tests::config.buffer_size;
+	const float freq = fftune::FreqA4 + 0.3f * resolution;
+	fftune::gen_sine(freq, tests::config.sample_rate, buf.data, buf.size);
+	const auto &spectrum = fft.detect_spectrum(buf);
+
+	fftune::spectral_peaks peaks;
+	fftune::find_peaks(spectrum, 0, spectrum.size(), peaks);
+	ASSERT_FALSE(peaks.empty());
+	for (const auto &p : peaks) {
+		EXPECT_GE(spectrum.magnitudes[p.index], spectrum.magnitudes[p.index - 1]);
+		EXPECT_GE(spectrum.magnitudes[p.index], spectrum.magnitudes[p.index + 1]);
+		EXPECT_LE(std::abs(p.frequency - spectrum.frequencies[p.index]), 0.5f * resolution);
+	}
+	const auto loudest = std::ranges::max_element(peaks, {}, &fftune::spectral_peak::magnitude);
+	const auto nearest_bin = std::round(freq / resolution) * resolution;
+	EXPECT_LT(std::abs(loudest->frequency - freq), std::abs(nearest_bin - freq));
+
+	// a range only yields the peaks within it
+	const auto first = loudest->index + 1;
+	fftune::find_peaks(spectrum, first, spectrum.size(), peaks);
+	for (const auto &p : peaks) {
+		EXPECT_GE(p.index, first);
+	}
+}
+
+TEST_F(FftTest, PhaseFrequency) {
+	// the phase advance between overlapping buffers must tell the frequency more accurately than the magnitudes
+	const size_t hop_size = buf.size / 4;
+	auto fft = fftune::fft(buf.size, tests::config.sample_rate);
+	std::vector<fftune::spectrum_buffer> spectra(2);
+	for (const float freq : {110.f, 333.3f, 1000.f}) {
+		std::vector<float> samples(buf.size + hop_size);
+		fftune::gen_sine(freq, tests::config.sample_rate, samples.data(), samples.size());
+		fft.detect(samples.data(), spectra.size(), hop_size, spectra);
+		const auto &spectrum = spectra.back();
+		const auto index = std::distance(spectrum.magnitudes.begin(), std::ranges::max_element(spectrum.magnitudes));
+		const auto parabolic = spectrum.interpolated_frequency(index);
+		const auto phase = spectrum.phase_frequency(spectra.front(), index, hop_size);
+		EXPECT_LT(std::abs(parabolic - freq), std::abs(spectrum.frequencies[index] - freq));
+		EXPECT_NEAR(freq, phase, 0.1f);
+	}
+}
+
 TEST_F(FftTest, Sizes) {
 	// fft should work for all sorts of different buffer sizes
 	constexpr const size_t max_bufsize = 32768;
@@ -102,3 +152,224 @@ TEST_F(FftTest, Heuristics) {
 		check_bins(bins);
 	}
 }
+
+TEST_F(FftTest, SpectrumBuffer) {
+	// the reusable spectrum must hold the same data as the bins and must not be reallocated
+	auto fft = fftune::fft(tests::config.buffer_size, tests::config.sample_rate);
+	fftune::gen_sine(fftune::FreqA4, tests::config.sample_rate, buf.data, buf.size);
+	const auto bins = fft.detect(buf);
+	const auto &spectrum = fft.detect_spectrum(buf);
+	const auto *magnitudes = spectrum.magnitudes.data();
+
+	ASSERT_EQ(bins.size(), spectrum.size());
+	EXPECT_EQ(bins, spectrum.to_bins());
+	for (size_t i = 0; i < bins.size(); ++i) {
+		EXPECT_FLOAT_EQ(bins[i].magnitude, spectrum.magnitudes[i]);
+		EXPECT_FLOAT_EQ(bins[i].frequency, spectrum.frequencies[i]);
+	}
+
+	fftune::gen_sine(fftune::FreqA4 / 2.f, tests::config.sample_rate, buf.data, buf.size);
+	EXPECT_EQ(&fft.detect_spectrum(buf), &spectrum);
+	EXPECT_EQ(spectrum.magnitudes.data(), magnitudes);
+	check_bins(spectrum.to_bins(), 2.f, fftune::FreqA4 / 2.f);
+}
+
+TEST_F(FftTest, CallerOwnedSpectrum) {
+	// a caller owned spectrum must match the bins and must only be allocated once
+	auto fft = fftune::fft(tests::config.buffer_size, tests::config.sample_rate);
+	fftune::gen_sine(fftune::FreqA4, tests::config.sample_rate, buf.data, buf.size);
+	const auto bins = fft.detect(buf);
+	fftune::spectrum_buffer spectrum;
+	fft.detect(buf, spectrum, {.powers = true});
+	const auto *values = spectrum.values.data();
+
+	ASSERT_EQ(bins.size(), spectrum.size());
+	EXPECT_EQ(bins, spectrum.to_bins());
+	for (size_t i = 0; i < bins.size(); ++i) {
+		EXPECT_NEAR(std::pow(10.f, spectrum.magnitudes[i] / 10.f), spectrum.powers[i], 1e-3f * spectrum.powers[i] + 1e-12f);
+	}
+
+	// fields that were not requested are left untouched
+	fftune::gen_sine(fftune::FreqA4 / 2.f, tests::config.sample_rate, buf.data, buf.size);
+	const auto magnitudes = spectrum.magnitudes;
+	fft.detect(buf, spectrum, {.magnitudes = false, .frequencies = false});
+	EXPECT_EQ(spectrum.values.data(), values);
+	EXPECT_EQ(spectrum.magnitudes, magnitudes);
+	fft.detect(buf, spectrum);
+	check_bins(spectrum.to_bins(), 2.f, fftune::FreqA4 / 2.f);
+}
+
+TEST_F(FftTest, Batch) {
+	// every spectrum of a batch must match the spectrum of its frame
+	constexpr const size_t hop_size = 64;
+	constexpr const size_t num_frames = fftune::fft::max_batch + 3;
+	auto fft = fftune::fft(tests::config.buffer_size, tests::config.sample_rate);
+	fftune::sample_buffer samples {(num_frames - 1) * hop_size + buf.size};
+	fftune::gen_harmonic(fftune::FreqA4, tests::config.sample_rate, samples.data, samples.size);
+	std::vector<fftune::spectrum_buffer> batch(num_frames);
+	fft.detect(samples.data, num_frames, hop_size, batch);
+
+	for (size_t i = 0; i < num_frames; ++i) {
+		buf.read(samples.data + i * hop_size, buf.size);
+		const auto &expected = fft.detect_spectrum(buf);
+		ASSERT_EQ(expected.size(), batch[i].size());
+		for (size_t j = 0; j < expected.size(); ++j) {
+			EXPECT_FLOAT_EQ(expected.magnitudes[j], batch[i].magnitudes[j]);
+		}
+	}
+}
+
+TEST_F(FftTest, ForEachSpectrum) {
+	// every frame must be visited in order with its spectrum, and with the spectrum before it if the frames overlap
+	constexpr const size_t num_frames = 2 * fftune::fft::max_batch + 3;
+	auto fft = fftune::fft(tests::config.buffer_size, tests::config.sample_rate);
+	for (const size_t hop_size : {size_t(64), buf.size}) {
+		fftune::sample_buffer samples {(num_frames - 1) * hop_size + buf.size};
+		fftune::gen_harmonic(fftune::FreqA4, tests::config.sample_rate, samples.data, samples.size);
+		std::vector<fftune::spectrum_buffer> expected(num_frames);
+		fft.detect(samples.data, num_frames, hop_size, expected);
+
+		size_t visited = 0;
+		fft.for_each_spectrum(samples.data, num_frames, hop_size, [&](size_t frame, const fftune::spectrum_buffer &spectrum, const fftune::spectrum_buffer *before) {
+			ASSERT_EQ(frame, visited++);
+			EXPECT_EQ(expected[frame].magnitudes, spectrum.magnitudes);
+			if (frame == 0 || hop_size >= buf.size) {
+				EXPECT_EQ(before, nullptr);
+			} else {
+				ASSERT_NE(before, nullptr);
+				EXPECT_EQ(expected[frame - 1].magnitudes, before->magnitudes);
+			}
+		});
+		EXPECT_EQ(visited, num_frames);
+	}
+}
+
+TEST_F(FftTest, Sliding) {
+	// sliding over a stream must yield the same spectra as transforming every buffer from scratch
+	fftune::config conf = tests::config;
+	conf.hop_size = fftune::fft::max_sliding_hop;
+	conf.spectrum = fftune::spectrum_method::Sliding;
+	EXPECT_EQ(conf.error(), fftune::config_error::Sliding_Window);
+
+	constexpr const std::array windows = {fftune::window_type::Rectangular, fftune::window_type::Hanning, fftune::window_type::Hamming};
+	fftune::sample_buffer stream {2 * conf.buffer_size};
+	fftune::gen_harmonic(fftune::FreqA4, conf.sample_rate, stream.data, conf.buffer_size);
+	fftune::gen_harmonic(fftune::FreqA4 / 2.f, conf.sample_rate, stream.data + conf.buffer_size, conf.buffer_size);
+	// hops above fft::max_sliding_hop fall back to full transformations
+	for (const size_t hop : {conf.hop_size, 2 * fftune::fft::max_sliding_hop}) {
+		conf.hop_size = hop;
+		for (auto w : windows) {
+			conf.window = w;
+			ASSERT_TRUE(fftune::config_error_okay(conf.error()));
+			fftune::fft sliding {conf};
+			fftune::fft full {conf.buffer_size, conf.sample_rate, fftune::fft_heuristic::OptimizeRuntime, w};
+			fftune::spectrum_buffer spectrum;
+			for (size_t offset = 0; offset + buf.size <= stream.size; offset += conf.hop_size) {
+				buf.read(stream.data + offset, buf.size);
+				sliding.detect(buf, spectrum);
+				const auto &expected = full.detect_spectrum(buf);
+				const auto peak = std::ranges::max(expected.values, {}, [](const auto &v) { return std::abs(v); });
+				for (size_t i = 0; i < expected.size(); ++i) {
+					EXPECT_LT(std::abs(expected.values[i] - spectrum.values[i]), 1e-4f * std::abs(peak));
+				}
+			}
+		}
+	}
+}
+
+TEST_F(FftTest, Windows) {
+	// every window must be cached and must match its windowing function
+	constexpr const std::array windows = {fftune::window_type::Rectangular, fftune::window_type::Hanning, fftune::window_type::Hamming, fftune::window_type::Welch};
+	for (auto w : windows) {
+		const auto &table = fftune::window::table(w, buf.size);
+		EXPECT_EQ(&table, &fftune::window::table(w, buf.size));
+		ASSERT_EQ(table.size(), buf.size);
+		const auto f = fftune::window::function(w);
+		for (size_t i = 0; i < buf.size; ++i) {
+			EXPECT_FLOAT_EQ(table[i], f(i, buf.size));
+		}
+
+		auto fft = fftune::fft(tests::config.buffer_size, tests::config.sample_rate, fftune::fft_heuristic::OptimizeInit, w);
+		fftune::gen_sine(fftune::FreqA4, tests::config.sample_rate, buf.data, buf.size);
+		check_bins(fft.detect(buf));
+	}
+}
+
+TEST_F(FftTest, Builtin) {
+	// the bundled FFT must match a naive DFT and invert itself, for power-of-two sizes as well as for all others
+	constexpr const std::array sizes = {size_t {2}, size_t {4}, size_t {64}, size_t {100}, size_t {1024}};
+	for (const auto size : sizes) {
+		const fftune::builtin_fft transform {size};
+		std::vector<float> samples(size);
+		fftune::gen_harmonic(fftune::FreqA4, tests::config.sample_rate, samples.data(), size);
+		std::vector<std::complex<float>> values(size / 2 + 1);
+		transform.forward(samples.data(), values.data());
+
+		float peak = 0.f;
+		for (size_t k = 0; k < values.size(); ++k) {
+			std::complex<double> expected = 0.0;
+			for (size_t j = 0; j < size; ++j) {
+				expected += static_cast<double>(samples[j]) * std::polar(1.0, -2.0 * M_PI * j * k / size);
+			}
+			peak = std::max(peak, static_cast<float>(std::abs(expected)));
+			EXPECT_NEAR(expected.real(), values[k].real(), 1e-3f * size);
+			EXPECT_NEAR(expected.imag(), values[k].imag(), 1e-3f * size);
+		}
+
+		std::vector<float> restored(size);
+		transform.inverse(values.data(), restored.data());
+		for (size_t j = 0; j < size; ++j) {
+			EXPECT_NEAR(samples[j], restored[j] / size, 1e-4f * std::max(1.f, peak));
+		}
+	}
+}
+
+#ifdef HAS_FFTW3F
+TEST_F(FftTest, Wisdom) {
+	// generated wisdom must be importable again
+	const auto path = std::filesystem::temp_directory_path() / "fftune-test.wisdom";
+	std::filesystem::remove(path);
+	ASSERT_TRUE(fftune::fft_generate_wisdom({tests::config.buffer_size}, path));
+	EXPECT_TRUE(std::filesystem::exists(path));
+	EXPECT_TRUE(fftune::fft_import_wisdom(path));
+
+	// detectors that use the wisdom must still work
+	fftune::config conf = tests::config;
+	conf.wisdom_path = &path;
+	fftune::pitch_detector<fftune::fast_comb_config> p {conf};
+	fftune::gen_sine(fftune::FreqA4, tests::config.sample_rate, buf.data, buf.size);
+	const auto notes = p.detect(buf);
+	ASSERT_FALSE(notes.empty());
+	EXPECT_EQ(fftune::MidiA4, notes.front().note);
+
+	// detectors, that do not plan new FFTs, must not rewrite the wisdom
+	std::filesystem::remove(path);
+	fftune::pitch_detector<fftune::fast_comb_config> same_size {conf};
+	fftune::pitch_detector<fftune::yin_config> yin {conf};
+	EXPECT_FALSE(std::filesystem::exists(path));
+}
+#endif
+
+TEST_F(FftTest, Concurrent) {
+	// fft objects must be constructible and usable from multiple threads at once
+	fftune::gen_sine(fftune::FreqA4, tests::config.sample_rate, buf.data, buf.size);
+	auto reference = fftune::fft(tests::config.buffer_size, tests::config.sample_rate);
+	const auto expected = reference.detect(buf);
+
+	constexpr const size_t num_threads = 8;
+	std::array<fftune::bins, num_threads> results;
+	{
+		std::vector<std::jthread> threads;
+		for (size_t t = 0; t < num_threads; ++t) {
+			threads.emplace_back([&, t] {
+				// mix sizes, so that new plans are created concurrently as well
+				fftune::fft other {tests::config.buffer_size * (2 + t % 2), tests::config.sample_rate};
+				fftune::fft fft {tests::config.buffer_size, tests::config.sample_rate};
+				results[t] = fft.detect(buf);
+			});
+		}
+	}
+	for (const auto &bins : results) {
+		EXPECT_EQ(expected, bins);
+	}
+}
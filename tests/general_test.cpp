@@ -1,6 +1,20 @@
 #include "tests.hpp"
+#include "util/worker_pool.hpp"
 
 TEST(General, Version) {
 	// version should be set
 	EXPECT_FALSE(fftune::version_string().empty());
 }
+
+TEST(General, WorkerPool) {
+	// every worker must run every task exactly once, and all of them must be done when run() returns
+	for (size_t num_workers : {1, 4}) {
+		fftune::worker_pool pool {num_workers};
+		ASSERT_EQ(pool.size(), num_workers);
+		std::vector<size_t> runs(num_workers);
+		for (size_t task = 1; task <= 100; ++task) {
+			pool.run([&](size_t worker) { ++runs[worker]; });
+			EXPECT_EQ(runs, std::vector<size_t>(num_workers, task));
+		}
+	}
+}
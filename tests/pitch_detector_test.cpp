@@ -1,3 +1,5 @@
+#include <numbers>
+
 #include "tests.hpp"
 
 class PitchDetectorTest : public ::testing::Test {
@@ -27,6 +29,138 @@ TEST_F(PitchDetectorTest, Yin) {
 	ASSERT_EQ(fftune::MidiA4, notes.front().note);
 }
 
+TEST_F(PitchDetectorTest, YinNoteRange) {
+	// narrowing the note range must not change the notes found within it, the full range may find notes outside of it instead
+	fftune::config conf = tests::config;
+	fftune::pitch_detector<fftune::yin_config> full {conf};
+	fftune::pitch_detector<fftune::yin_patient_config> patient_full {conf};
+	conf.min_note = fftune::MidiA4 - 12;
+	conf.max_note = fftune::MidiA4 + 12;
+	fftune::pitch_detector<fftune::yin_config> narrow {conf};
+	fftune::pitch_detector<fftune::yin_patient_config> patient_narrow {conf};
+
+	for (int note = conf.min_note; note <= conf.max_note; ++note) {
+		gen.gen_harmonics(buf, {fftune::note_estimate(note)});
+		for (auto [expected, notes] : {std::pair(full.detect(buf), narrow.detect(buf)), std::pair(patient_full.detect(buf), patient_narrow.detect(buf))}) {
+			if (expected.empty() || !conf.note_in_range(expected.front().note)) {
+				continue;
+			}
+			ASSERT_FALSE(notes.empty()) << note;
+			EXPECT_EQ(expected.front().note, notes.front().note) << note;
+		}
+	}
+}
+
+TEST_F(PitchDetectorTest, YinFft) {
+	// the fft based difference function must yield the same notes as the direct one
+	fftune::config conf = tests::config;
+	conf.max_polyphony = 2;
+	fftune::pitch_detector<fftune::yin_config> direct {conf};
+	fftune::pitch_detector<fftune::yin_patient_config> patient_direct {conf};
+	conf.yin_difference = fftune::difference_method::Fft;
+	fftune::pitch_detector<fftune::yin_config> fast {conf};
+	fftune::pitch_detector<fftune::yin_patient_config> patient_fast {conf};
+
+	const int d4 = fftune::MidiA4 - 7;
+	const std::array<fftune::note_estimates, 2> chords = {{{fftune::note_estimate(fftune::MidiA4)}, {fftune::note_estimate(d4), fftune::note_estimate(fftune::MidiA4)}}};
+	for (const auto &chord : chords) {
+		gen.gen_harmonics(buf, chord);
+		for (auto [expected, notes] : {std::pair(direct.detect(buf), fast.detect(buf)), std::pair(patient_direct.detect(buf), patient_fast.detect(buf))}) {
+			ASSERT_FALSE(notes.empty());
+			ASSERT_EQ(expected.size(), notes.size());
+			for (size_t i = 0; i < notes.size(); ++i) {
+				EXPECT_EQ(expected[i].note, notes[i].note);
+			}
+		}
+	}
+}
+
+TEST_F(PitchDetectorTest, YinDecimated) {
+	// the coarse search must find the same notes as computing every lag at full resolution
+	fftune::config conf = tests::config;
+	fftune::pitch_detector<fftune::yin_config> direct {conf};
+	fftune::pitch_detector<fftune::yin_patient_config> patient_direct {conf};
+	conf.yin_difference = fftune::difference_method::Decimated;
+	ASSERT_TRUE(fftune::config_error_okay(conf.error()));
+	fftune::pitch_detector<fftune::yin_config> coarse {conf};
+	fftune::pitch_detector<fftune::yin_patient_config> patient_coarse {conf};
+
+	for (int note = fftune::MidiA4 - 36; note <= fftune::MidiA4 + 36; note += 5) {
+		gen.gen_harmonics(buf, {fftune::note_estimate(note)});
+		for (auto [expected, notes] : {std::pair(direct.detect(buf), coarse.detect(buf)), std::pair(patient_direct.detect(buf), patient_coarse.detect(buf))}) {
+			ASSERT_EQ(expected.size(), notes.size()) << note;
+			for (size_t i = 0; i < notes.size(); ++i) {
+				EXPECT_EQ(expected[i].note, notes[i].note) << note;
+			}
+		}
+	}
+
+	// the factor must neither be 0 nor skip whole periods of the highest note
+	for (const size_t factor : {size_t(0), static_cast<size_t>(fftune::freq_to_wavelength(conf.max_frequency(), conf.sample_rate)) + 1}) {
+		conf.yin_decimation = factor;
+		EXPECT_EQ(conf.error(), fftune::config_error::Invalid_Decimation) << factor;
+	}
+}
+
+TEST_F(PitchDetectorTest, YinIncremental) {
+	// sliding over a stream with a small hop must yield the same lags as computing them from scratch
+	fftune::config conf = tests::config;
+	conf.hop_size = conf.buffer_size / 16;
+	fftune::difference_function direct {conf};
+	conf.yin_difference = fftune::difference_method::Incremental;
+	fftune::difference_function incremental {conf};
+
+	// a stream of four consecutive notes
+	fftune::sample_buffer stream {4 * conf.buffer_size};
+	for (int i = 0; i < 4; ++i) {
+		gen.gen_harmonics(buf, {fftune::note_estimate(fftune::MidiA4 - 5 * i)});
+		stream.read(buf);
+	}
+
+	fftune::sample_buffer window {conf.buffer_size};
+	window.read(stream.data, window.size);
+	for (size_t offset = window.size; offset <= stream.size; offset += conf.hop_size) {
+		direct.update(window);
+		incremental.update(window);
+		for (size_t tau = direct.min_lag(); tau <= direct.max_lag(); tau += 7) {
+			const auto expected = direct(tau);
+			EXPECT_NEAR(expected, incremental(tau), 1e-3f * std::max(1.f, expected));
+		}
+		if (offset < stream.size) {
+			window.read(stream.data + offset, conf.hop_size);
+		}
+	}
+}
+
+TEST_F(PitchDetectorTest, NoteRange) {
+	fftune::config conf = tests::config;
+	conf.min_note = fftune::MidiA4 + 1;
+	conf.max_note = fftune::MidiA4;
+	EXPECT_EQ(conf.error(), fftune::config_error::Invalid_Note_Range);
+
+	// a narrow range around the note must still find it
+	conf.min_note = fftune::MidiA4 - 12;
+	conf.max_note = fftune::MidiA4 + 12;
+	ASSERT_TRUE(fftune::config_error_okay(conf.error()));
+	fftune::pitch_detector<fftune::yin_config> yin {conf};
+	fftune::pitch_detector<fftune::fast_comb_config> comb {conf};
+	for (const auto &notes : {yin.detect(buf), comb.detect(buf)}) {
+		ASSERT_FALSE(notes.empty());
+		EXPECT_EQ(fftune::MidiA4, notes.front().note);
+	}
+
+	// a range that excludes the note must never report anything outside of it
+	conf.min_note = fftune::MidiA4 + 1;
+	conf.max_note = fftune::MidiMax;
+	fftune::pitch_detector<fftune::yin_config> high_yin {conf};
+	fftune::pitch_detector<fftune::fast_comb_config> high_comb {conf};
+	for (const auto &notes : {high_yin.detect(buf), high_comb.detect(buf)}) {
+		for (const auto &n : notes) {
+			EXPECT_TRUE(conf.note_in_range(n.note));
+		}
+	}
+}
+
 TEST_F(PitchDetectorTest, Comb) {
 	fftune::pitch_detector<fftune::fast_comb_config> p {tests::config};
 	const auto notes = p.detect(buf);
@@ -35,6 +169,88 @@ TEST_F(PitchDetectorTest, Comb) {
 	ASSERT_EQ(fftune::MidiA4, notes.front().note);
 }
 
+/**
+ * The notes fast_comb found before the bins of possible overtones and subharmonics were precomputed,
+ * by comparing every peak with every other one.
+ * It keeps two deliberate changes: overtones need a ratio of at least 1, where peaks far below used to count with the ratio 0,
+ * and the full magnitude of the picked peak is subtracted, where it used to drop to 0 once the peak itself was subtracted.
+ */
+fftune::note_estimates comb_all_bins(const fftune::config &conf, const fftune::spectrum_buffer &spectrum) {
+	fftune::note_estimates result;
+	constexpr const float magnitude_factor = 1.1f;
+	constexpr const float tolerance = (fftune::SemitoneRatio - 1.f) / 0.25;
+	const auto [first, last] = fftune::fft(conf).bins_range(conf);
+	fftune::spectral_peaks peaks;
+	fftune::find_peaks(spectrum, first, last, peaks);
+	std::ranges::sort(peaks, [](const auto &l, const auto &r) { return l.magnitude > r.magnitude; });
+	for (size_t voice = 0; voice < conf.max_polyphony && !peaks.empty(); ++voice) {
+		size_t best = 0;
+		auto magnitude = magnitude_factor * peaks[best].magnitude;
+		for (size_t candidate = 1; candidate < peaks.size(); ++candidate) {
+			if (peaks[candidate].magnitude > magnitude) {
+				const auto factor = peaks[best].frequency / peaks[candidate].frequency;
+				if (std::abs(factor - std::round(factor)) < tolerance && factor > 1.5f) {
+					best = candidate;
+					magnitude = magnitude_factor * peaks[best].magnitude;
+				}
+			}
+		}
+		result.push_back(fftune::note_estimate(fftune::pitch_estimate(peaks[best].frequency, peaks[best].magnitude)));
+		const auto best_magnitude = std::abs(peaks[best].magnitude);
+		for (auto &overtone : peaks) {
+			const auto factor = overtone.frequency / peaks[best].frequency;
+			if (std::abs(factor - std::round(factor)) < tolerance && std::round(factor) >= 1.f) {
+				overtone.magnitude -= best_magnitude;
+			}
+		}
+		peaks.erase(peaks.begin() + best);
+		std::ranges::sort(peaks, [](const auto &l, const auto &r) { return l.magnitude > r.magnitude; });
+	}
+	return result;
+}
+
+TEST_F(PitchDetectorTest, CombIntervals) {
+	// the precomputed bins of overtones and subharmonics must find the same notes as comparing all peaks, even if notes share overtones
+	fftune::config conf = tests::config;
+	const int a3 = fftune::MidiA4 - 12;
+	const int c4 = fftune::MidiA4 - 9;
+	const int d4 = fftune::MidiA4 - 7;
+	const int e4 = fftune::MidiA4 - 5;
+	const std::array<fftune::note_estimates, 4> chords = {{
+		{fftune::note_estimate(a3), fftune::note_estimate(fftune::MidiA4)},
+		{fftune::note_estimate(d4), fftune::note_estimate(fftune::MidiA4)},
+		{fftune::note_estimate(a3), fftune::note_estimate(e4), fftune::note_estimate(fftune::MidiA4)},
+		{fftune::note_estimate(a3 - 12), fftune::note_estimate(c4), fftune::note_estimate(e4), fftune::note_estimate(fftune::MidiA4 + 12)},
+	}};
+	for (const auto &chord : chords) {
+		// more voices than notes, so that the remaining overtones are picked as well
+		conf.max_polyphony = chord.size() + 2;
+		fftune::fast_comb comb {conf};
+		fftune::fft spec {conf};
+		gen.gen_harmonics(buf, chord);
+		const auto &spectrum = spec.detect_spectrum(buf);
+
+		const auto expected = comb_all_bins(conf, spectrum);
+		const auto notes = comb.detect(spectrum);
+		ASSERT_EQ(expected.size(), notes.size());
+		for (size_t i = 0; i < notes.size(); ++i) {
+			EXPECT_EQ(expected[i].note, notes[i].note) << i;
+			EXPECT_EQ(expected[i].velocity, notes[i].velocity) << i;
+		}
+	}
+}
+
+TEST_F(PitchDetectorTest, DoubleFft) {
+	fftune::pitch_detector<fftune::double_fft_config> p {tests::config};
+	// the cepstrum must find the period of the harmonic series from low to high notes
+	for (int note = fftune::MidiA4 - 24; note <= fftune::MidiA4 + 24; note += 6) {
+		gen.gen_harmonics(buf, {fftune::note_estimate(note)});
+		const auto notes = p.detect(buf);
+		ASSERT_FALSE(notes.empty());
+		EXPECT_EQ(note, notes.front().note);
+	}
+}
+
 TEST_F(PitchDetectorTest, Sfizz) {
 	fftune::pitch_detector<fftune::fftune_sfizz_config> p {tests::config};
 	const auto notes = p.detect(buf);
@@ -43,6 +259,44 @@ TEST_F(PitchDetectorTest, Sfizz) {
 	ASSERT_EQ(fftune::MidiA4, notes.front().note);
 }
 
+TEST_F(PitchDetectorTest, Spectral) {
+	fftune::config conf = tests::config;
+	// a window with low sidelobes, so that quiet peaks are not buried below the leakage of loud ones
+	conf.window = fftune::window_type::Hanning;
+	const auto add_sine = [&](float freq, float amplitude) {
+		for (size_t i = 0; i < buf.size; ++i) {
+			buf.data[i] += amplitude * std::sin(2.f * std::numbers::pi_v<float> * freq * i / conf.sample_rate);
+		}
+	};
+
+	// a low note with a weak fundamental is found through the weight of all of its partials
+	const int a2 = fftune::MidiA4 - 24;
+	conf.max_polyphony = 1;
+	fftune::pitch_detector<fftune::fftune_spectral_config> low {conf};
+	std::fill_n(buf.data, buf.size, 0.f);
+	add_sine(fftune::midi_to_freq(a2), 0.01f);
+	for (int harmonic = 2; harmonic <= 16; ++harmonic) {
+		add_sine(harmonic * fftune::midi_to_freq(a2), 0.1f);
+	}
+	auto notes = low.detect(buf);
+	ASSERT_EQ(1, notes.size());
+	EXPECT_EQ(a2, notes.front().note);
+
+	// a quiet note is found within the dynamic range of 80 dB below the loudest peak, but considered noise below it
+	const int e3 = fftune::MidiA4 - 17;
+	conf.max_polyphony = 4;
+	fftune::pitch_detector<fftune::fftune_spectral_config> p {conf};
+	for (const auto [level, expected] : {std::pair(-75.f, true), std::pair(-85.f, false)}) {
+		std::fill_n(buf.data, buf.size, 0.f);
+		add_sine(fftune::FreqA4, 0.5f);
+		add_sine(fftune::midi_to_freq(e3), 0.5f * std::pow(10.f, level / 20.f));
+		notes = p.detect(buf);
+		ASSERT_FALSE(notes.empty());
+		EXPECT_EQ(fftune::MidiA4, notes.front().note);
+		EXPECT_EQ(expected, std::ranges::any_of(notes, [&](const auto &n) { return n.note == e3; })) << level;
+	}
+}
+
 TEST_F(PitchDetectorTest, Polyphonic) {
 	fftune::config conf = tests::config;
 	// test polyphony
@@ -63,3 +317,107 @@ TEST_F(PitchDetectorTest, Polyphonic) {
 	 */
 	ASSERT_TRUE((notes[0].note == fftune::MidiA4 && notes[1].note == d4) || notes[0].note == d4 && notes[1].note == fftune::MidiA4);
 }
+
+TEST_F(PitchDetectorTest, PolyphonicThreads) {
+	// multiple threads must come to exactly the same result
+	fftune::config conf = tests::config;
+	conf.max_polyphony = 2;
+	fftune::pitch_detector<fftune::fftune_sfizz_config> serial {conf};
+	conf.num_threads = 4;
+	fftune::pitch_detector<fftune::fftune_sfizz_config> parallel {conf};
+
+	const int d4 = fftune::MidiA4 - 7;
+	gen.gen_harmonics(buf, {fftune::note_estimate(d4), fftune::note_estimate(fftune::MidiA4)});
+
+	const auto expected = serial.detect(buf);
+	const auto notes = parallel.detect(buf);
+	ASSERT_EQ(expected.size(), notes.size());
+	for (size_t i = 0; i < notes.size(); ++i) {
+		EXPECT_EQ(expected[i].note, notes[i].note);
+		EXPECT_EQ(expected[i].confidence, notes[i].confidence);
+	}
+}
+
+TEST_F(PitchDetectorTest, PolyphonicPruned) {
+	// a pruned search must still find the notes, even with more voices than an exhaustive search can handle
+	fftune::config conf = tests::config;
+	conf.search_width = 16;
+
+	const int d4 = fftune::MidiA4 - 7;
+	const int f4 = fftune::MidiA4 - 4;
+	const std::array<fftune::note_estimates, 2> chords = {{{fftune::note_estimate(d4), fftune::note_estimate(fftune::MidiA4)}, {fftune::note_estimate(d4), fftune::note_estimate(f4), fftune::note_estimate(fftune::MidiA4)}}};
+	for (const auto &chord : chords) {
+		conf.max_polyphony = chord.size();
+		fftune::pitch_detector<fftune::fftune_sfizz_config> p {conf};
+		gen.gen_harmonics(buf, chord);
+
+		const auto notes = p.detect(buf);
+		ASSERT_EQ(chord.size(), notes.size());
+		for (const auto &n : chord) {
+			EXPECT_TRUE(std::ranges::any_of(notes, [&](const auto &e) { return e.note == n.note; }));
+		}
+	}
+}
+
+template<fftune::config T>
+void check_batch(const fftune::config &conf, const fftune::sample_buffer &stream) {
+	fftune::pitch_detector<T> single {conf};
+	fftune::pitch_detector<T> batched {conf};
+	const size_t num_frames = (stream.size - conf.buffer_size) / conf.hop_size + 1;
+	std::vector<fftune::note_estimates> batch;
+	batched.detect(stream.data, num_frames, conf.hop_size, batch);
+	ASSERT_EQ(num_frames, batch.size());
+
+	fftune::sample_buffer frame {conf.buffer_size};
+	for (size_t i = 0; i < num_frames; ++i) {
+		frame.read(stream.data + i * conf.hop_size, frame.size);
+		const auto expected = single.detect(frame);
+		ASSERT_EQ(expected.size(), batch[i].size());
+		for (size_t j = 0; j < expected.size(); ++j) {
+			EXPECT_EQ(expected[j].note, batch[i][j].note);
+		}
+	}
+}
+
+TEST_F(PitchDetectorTest, Batch) {
+	// detecting a batch of frames must yield the same notes as detecting them one by one
+	fftune::config conf = tests::config;
+
+	// a stream of consecutive notes, spanning more frames than a single batch
+	fftune::sample_buffer stream {20 * conf.buffer_size};
+	for (int i = 0; i < 20; ++i) {
+		gen.gen_harmonics(buf, {fftune::note_estimate(fftune::MidiA4 - 5 * (i % 4))});
+		stream.read(buf);
+	}
+
+	// overlapping frames would let the spectral backends use the phase of the previous frame
+	conf.hop_size = conf.buffer_size;
+	check_batch<fftune::fast_comb_config>(conf, stream);
+	check_batch<fftune::fftune_spectral_config>(conf, stream);
+	check_batch<fftune::double_fft_config>(conf, stream);
+	conf.hop_size = conf.buffer_size / 8;
+	check_batch<fftune::yin_config>(conf, stream);
+}
+
+template<fftune::config T>
+void check_small_window(const fftune::config &conf, int note) {
+	fftune::pitch_detector<T> p {conf};
+	// two buffers of the same note, so that the later frames overlap their predecessors
+	std::vector<float> stream(2 * conf.buffer_size);
+	fftune::gen_harmonic(fftune::midi_to_freq(note), conf.sample_rate, stream.data(), stream.size());
+	std::vector<fftune::note_estimates> frames;
+	p.detect(stream.data(), conf.buffer_size / conf.hop_size + 1, conf.hop_size, frames);
+	ASSERT_FALSE(frames.back().empty());
+	EXPECT_EQ(note, frames.back().front().note);
+}
+
+TEST_F(PitchDetectorTest, SmallWindow) {
+	// interpolating the peaks must resolve the semitones of low notes, even though the bins are further apart
+	fftune::config conf = tests::config;
+	conf.buffer_size = 2048;
+	conf.hop_size = conf.buffer_size / 4;
+	for (int note = 40; note < 60; ++note) {
+		check_small_window<fftune::fast_comb_config>(conf, note);
+		check_small_window<fftune::fftune_spectral_config>(conf, note);
+	}
+}
@@ -0,0 +1,85 @@
+#include <tuple>
+
+#include "tests.hpp"
+#include "util/simd.hpp"
+
+constexpr const fftune::simd::instruction_set instruction_sets[] = {fftune::simd::instruction_set::Scalar, fftune::simd::instruction_set::Sse2, fftune::simd::instruction_set::Avx2, fftune::simd::instruction_set::Avx512};
+
+TEST(SimdTest, Kernels) {
+	// every instruction set must compute the same as the scalar single lag kernels, including the samples that do not fill a whole vector
+	const auto &scalar = fftune::simd::get(fftune::simd::instruction_set::Scalar);
+	for (const auto set : instruction_sets) {
+		if (!fftune::simd::supported(set)) {
+			continue;
+		}
+		const auto &kernels = fftune::simd::get(set);
+		for (const size_t size : {0, 1, 7, 33, 1000, 4099}) {
+			std::vector<float> a(size), b(size);
+			fftune::gen_sine(fftune::FreqA4, tests::config.sample_rate, a.data(), size);
+			fftune::gen_harmonic(fftune::FreqA4 / 4.f, tests::config.sample_rate, b.data(), size);
+			const auto tolerance = 1e-4f * (size + 1);
+
+			EXPECT_NEAR(scalar.squared_difference(a.data(), b.data(), size), kernels.squared_difference(a.data(), b.data(), size), tolerance) << fftune::simd::to_string(set) << " " << size;
+			for (const size_t tau : {size_t(0), size / 3, size - std::min(size, fftune::simd::lag_block / 2)}) {
+				// every lag of a block must match computing it on its own
+				float sums[fftune::simd::lag_block];
+				kernels.squared_differences(a.data(), size, tau, sums);
+				for (size_t k = 0; k < fftune::simd::lag_block; ++k) {
+					const auto expected = tau + k < size ? scalar.squared_difference(a.data(), a.data() + tau + k, size - tau - k) : 0.f;
+					EXPECT_NEAR(expected, sums[k], tolerance) << fftune::simd::to_string(set) << " " << size << " " << tau + k;
+				}
+			}
+			if (size >= fftune::simd::lag_block) {
+				// windows of the same length, both forwards from the start and backwards from the end
+				const auto count = size - fftune::simd::lag_block + 1;
+				float sums[fftune::simd::lag_block];
+				for (const auto [x, y, step] : {std::tuple(a.data(), a.data(), 1), std::tuple(a.data() + fftune::simd::lag_block - 1, a.data() + fftune::simd::lag_block - 1, -1)}) {
+					kernels.windowed_squared_differences(x, y, count, step, sums);
+					for (size_t k = 0; k < fftune::simd::lag_block; ++k) {
+						EXPECT_NEAR(scalar.squared_difference(x, y + static_cast<std::ptrdiff_t>(k) * step, count), sums[k], tolerance) << fftune::simd::to_string(set) << " " << size << " " << step;
+					}
+				}
+			}
+			EXPECT_NEAR(scalar.sum_abs(b.data(), size), kernels.sum_abs(b.data(), size), tolerance) << fftune::simd::to_string(set) << " " << size;
+
+			std::vector<float> expected(size), actual(size);
+			scalar.multiply(a.data(), b.data(), expected.data(), size);
+			kernels.multiply(a.data(), b.data(), actual.data(), size);
+			EXPECT_EQ(expected, actual) << fftune::simd::to_string(set) << " " << size;
+			scalar.scale(expected.data(), 0.5f, size);
+			kernels.scale(actual.data(), 0.5f, size);
+			EXPECT_EQ(expected, actual) << fftune::simd::to_string(set) << " " << size;
+
+			// unit phases and steps, as used for rotating the bins of a spectrum
+			std::vector<float> phase_re(size), phase_im(size), step_re(size), step_im(size);
+			for (size_t i = 0; i < size; ++i) {
+				phase_re[i] = std::cos(0.01f * i);
+				phase_im[i] = std::sin(0.01f * i);
+				step_re[i] = std::cos(0.003f * i);
+				step_im[i] = std::sin(0.003f * i);
+			}
+			const auto count = std::min<size_t>(size, 32);
+			std::vector<float> expected_im(size), actual_im(size);
+			scalar.rotating_sums(a.data(), count, phase_re.data(), phase_im.data(), step_re.data(), step_im.data(), expected.data(), expected_im.data(), size);
+			kernels.rotating_sums(a.data(), count, phase_re.data(), phase_im.data(), step_re.data(), step_im.data(), actual.data(), actual_im.data(), size);
+			for (size_t i = 0; i < size; ++i) {
+				EXPECT_NEAR(expected[i], actual[i], 1e-4f * (count + 1)) << fftune::simd::to_string(set) << " " << size;
+				EXPECT_NEAR(expected_im[i], actual_im[i], 1e-4f * (count + 1)) << fftune::simd::to_string(set) << " " << size;
+			}
+
+			if (size > 0) {
+				float expected_min, expected_max, min, max;
+				scalar.minmax(b.data(), size, expected_min, expected_max);
+				kernels.minmax(b.data(), size, min, max);
+				EXPECT_EQ(expected_min, min) << fftune::simd::to_string(set) << " " << size;
+				EXPECT_EQ(expected_max, max) << fftune::simd::to_string(set) << " " << size;
+			}
+		}
+	}
+}
+
+TEST(SimdTest, Dispatch) {
+	EXPECT_TRUE(fftune::simd::supported(fftune::simd::instruction_set::Scalar));
+	EXPECT_TRUE(fftune::simd::supported(fftune::simd::best_instruction_set()));
+	EXPECT_EQ(&fftune::simd::get(fftune::simd::best_instruction_set()), &fftune::simd::active());
+}
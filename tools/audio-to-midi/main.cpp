@@ -4,7 +4,7 @@
 #include <iostream>
 
 void show_usage() {
-	std::cout << R"(Usage: wav-to-midi [-hsomvepd] /path/to/input.wav
+	std::cout << R"(Usage: wav-to-midi [-hsomvepdjkwg] /path/to/input.wav
 
 	-h, --help		Show help
 	-s, --buf-size SIZE	Change buffer and window size
@@ -15,15 +15,29 @@ void show_usage() {
 	-e, --external-path P	Set the external path necessary for some algorithms
 	-p, --polyphony NUM	Set the maximum amount of voices
 	-d, --stiffness NUM 	Set the Midi stiffness
+	-j, --threads NUM	Set the number of worker threads
+	-k, --search-width NUM	Only combine the NUM most promising notes in polyphonic search
+	-w, --wisdom FILE	Load and save measured FFT plans in FILE
+	-g, --gen-wisdom SIZES	Only measure FFT plans for the comma separated buffer SIZES and save them to the wisdom file
 
 For more information visit the man page audio-to-midi(1).
 )";
 }
 
+std::vector<size_t> parse_sizes(const std::string &list) {
+	std::vector<size_t> result;
+	for (const auto size : std::views::split(list, ',')) {
+		result.push_back(std::stoul(std::string(size.begin(), size.end())));
+	}
+	return result;
+}
+
 int main(int argc, char *const argv[]) {
 	std::filesystem::path in_file;
 	std::filesystem::path out_file;
 	std::filesystem::path external_path;
+	std::filesystem::path wisdom_path;
+	std::vector<size_t> wisdom_sizes;
 	fftune::config config;
 	// parse args
 	constexpr struct option long_opts[] = {
@@ -36,8 +50,12 @@ int main(int argc, char *const argv[]) {
 		{"external-path", required_argument, nullptr, 'e'},
 		{"polyphony", required_argument, nullptr, 'p'},
 		{"stiffness", required_argument, nullptr, 'd'},
+		{"threads", required_argument, nullptr, 'j'},
+		{"search-width", required_argument, nullptr, 'k'},
+		{"wisdom", required_argument, nullptr, 'w'},
+		{"gen-wisdom", required_argument, nullptr, 'g'},
 		{nullptr, 0, nullptr, 0}};
-	constexpr const char *short_opts = "hs:o:m:ve:p:d:";
+	constexpr const char *short_opts = "hs:o:m:ve:p:d:j:k:w:g:";
 	int opt;
 	while ((opt = getopt_long(argc, argv, short_opts, long_opts, nullptr)) != -1) {
 		switch (opt) {
@@ -73,6 +91,24 @@ int main(int argc, char *const argv[]) {
 		case 'd':
 			config.midi_stiffness = atoi(optarg);
 			break;
+		case 'j':
+			config.num_threads = atoi(optarg);
+			break;
+		case 'k':
+			config.search_width = atoi(optarg);
+			break;
+		case 'w':
+			wisdom_path = optarg;
+			config.wisdom_path = &wisdom_path;
+			break;
+		case 'g':
+			try {
+				wisdom_sizes = parse_sizes(optarg);
+			} catch (const std::exception &e) {
+				std::cerr << "Invalid buffer sizes " << optarg << std::endl;
+				return 1;
+			}
+			break;
 		case '?':
 		default:
 			show_usage();
@@ -80,6 +116,20 @@ int main(int argc, char *const argv[]) {
 		}
 	}
 
+	if (!wisdom_sizes.empty()) {
+		// only generate wisdom
+		if (wisdom_path.empty()) {
+			std::cerr << "Generating wisdom requires a wisdom file" << std::endl;
+			return 1;
+		}
+#ifdef HAS_FFTW3F
+		return !fftune::fft_generate_wisdom(wisdom_sizes, wisdom_path);
+#else
+		std::cerr << "Generating wisdom requires fftw support" << std::endl;
+		return 1;
+#endif
+	}
+
 	if (optind >= argc) {
 		show_usage();
 		return 1;